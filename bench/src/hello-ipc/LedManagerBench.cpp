@@ -0,0 +1,94 @@
+#include "LedManager.hpp"
+#include "led_service.pb.h"
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+// Subclass to reach the protected state accessors
+class BenchLedManager : public hello_ipc::LedManager {
+public:
+    using hello_ipc::LedManager::UpdateLedState;
+    using hello_ipc::LedManager::GetLedState;
+    using hello_ipc::LedManager::ClassifyMessage;
+};
+
+// --- Benchmarks for the LED state table ---
+
+static void BM_UpdateLedState(benchmark::State &state) {
+    BenchLedManager manager;
+    const std::string led_num = "900";
+    bool on = false;
+    for (auto _ : state) {
+        on = !on;
+        benchmark::DoNotOptimize(
+            manager.UpdateLedState(led_num, on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF));
+    }
+    manager.Flush();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateLedState);
+
+// Controllers re-assert the state they want, so most updates change nothing
+static void BM_UpdateLedStateNoOp(benchmark::State &state) {
+    BenchLedManager manager;
+    const std::string led_num = "902";
+    manager.UpdateLedState(led_num, hello_ipc::LedState::ON);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.UpdateLedState(led_num, hello_ipc::LedState::ON));
+    }
+    manager.Flush();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateLedStateNoOp);
+
+static void BM_GetLedState(benchmark::State &state) {
+    BenchLedManager manager;
+    const std::string led_num = "901";
+    manager.UpdateLedState(led_num, hello_ipc::LedState::ON);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.GetLedState(led_num));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetLedState);
+
+// Each thread updates its own LED, so the threads mostly hit different shards
+static void BM_UpdateLedStateThreaded(benchmark::State &state) {
+    static BenchLedManager *manager = nullptr;
+    if (state.thread_index() == 0) {
+        manager = new BenchLedManager();
+    }
+    const std::string led_num = std::to_string(910 + state.thread_index());
+    bool on = false;
+    for (auto _ : state) {
+        on = !on;
+        benchmark::DoNotOptimize(
+            manager->UpdateLedState(led_num, on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF));
+    }
+    if (state.thread_index() == 0) {
+        delete manager;
+        manager = nullptr;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateLedStateThreaded)->Threads(1)->Threads(4)->UseRealTime();
+
+// Runs on the event loop thread for every message, before any worker sees it
+static void BM_ClassifyRequest(benchmark::State &state) {
+    BenchLedManager manager;
+    hello_ipc::Request req;
+    req.set_request_id(123456);
+    req.set_priority(hello_ipc::PRIORITY_BULK);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(state.range(0)); ++i) {
+        auto *update = req.mutable_batch_update_request()->add_updates();
+        update->set_led_id(i);
+        update->set_state(hello_ipc::LedState::ON);
+    }
+    const std::string message = req.SerializeAsString();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.ClassifyMessage(message, hello_ipc::Service::WireFormat::kProtobuf));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ClassifyRequest)->Arg(1)->Arg(256);
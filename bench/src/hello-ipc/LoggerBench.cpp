@@ -0,0 +1,68 @@
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+// --- Benchmarks for Logger::Log in every mode ---
+// The log files are unlinked as soon as they are opened, the loggers keep writing
+// to them but the millions of benchmark lines do not stay around in /tmp.
+
+static const char *const kBenchLogName = "LoggerBench";
+
+static void RemoveBenchLogs() {
+    std::filesystem::remove(std::string("/tmp/") + kBenchLogName + ".log");
+    std::filesystem::remove(std::string("/tmp/") + kBenchLogName + ".binlog");
+}
+
+// Async loggers are shared by the benchmark threads, so the ring sees real contention.
+static const hello_ipc::Logger &SharedLogger(hello_ipc::Logger::Format format) {
+    static const hello_ipc::Logger text_logger(kBenchLogName, hello_ipc::Logger::Mode::kAsync);
+    static const hello_ipc::Logger binary_logger(kBenchLogName, hello_ipc::Logger::Mode::kAsync,
+                                                 hello_ipc::Logger::Format::kBinary);
+    static bool removed = (RemoveBenchLogs(), true);
+    (void)removed;
+    return format == hello_ipc::Logger::Format::kBinary ? binary_logger : text_logger;
+}
+
+static void BM_LoggerLogSync(benchmark::State &state) {
+    hello_ipc::Logger logger(kBenchLogName);
+    RemoveBenchLogs();
+    const std::string message = "Updated LED 17 to state: on";
+    for (auto _ : state) {
+        logger.Log(message);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLogSync);
+
+static void BM_LoggerLogAsync(benchmark::State &state) {
+    const hello_ipc::Logger &logger = SharedLogger(hello_ipc::Logger::Format::kText);
+    const std::string message = "Updated LED 17 to state: on";
+    uint64_t dropped_before = logger.dropped();
+    for (auto _ : state) {
+        logger.Log(message);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        // Every thread sees the shared total, report it once
+        state.counters["dropped"] = static_cast<double>(logger.dropped() - dropped_before);
+    }
+}
+BENCHMARK(BM_LoggerLogAsync)->Threads(1)->Threads(4);
+
+static void BM_LoggerLogStructuredBinary(benchmark::State &state) {
+    const hello_ipc::Logger &logger = SharedLogger(hello_ipc::Logger::Format::kBinary);
+    const std::string led_num = "17";
+    uint64_t dropped_before = logger.dropped();
+    for (auto _ : state) {
+        logger.Log(hello_ipc::LogId::kLedUpdated, led_num, "on");
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        // Every thread sees the shared total, report it once
+        state.counters["dropped"] = static_cast<double>(logger.dropped() - dropped_before);
+    }
+}
+BENCHMARK(BM_LoggerLogStructuredBinary)->Threads(1)->Threads(4);
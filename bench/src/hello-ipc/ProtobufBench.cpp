@@ -0,0 +1,72 @@
+#include "led_service.pb.h"
+
+#include <string>
+
+#include <google/protobuf/arena.h>
+
+#include <benchmark/benchmark.h>
+
+// --- Benchmarks for the request wire format ---
+
+static hello_ipc::Request MakeUpdateRequest(bool numeric_id = false) {
+    hello_ipc::Request req;
+    req.set_request_id(42);
+    auto *update_req = req.mutable_update_request();
+    if (numeric_id) {
+        update_req->set_led_id(17);
+    } else {
+        update_req->set_led_num("17");
+    }
+    update_req->set_state(hello_ipc::LedState::ON);
+    return req;
+}
+
+static void BM_RequestSerialize(benchmark::State &state) {
+    hello_ipc::Request req = MakeUpdateRequest();
+    std::string message;
+    for (auto _ : state) {
+        req.SerializeToString(&message);
+        benchmark::DoNotOptimize(message.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestSerialize);
+
+static void BM_RequestParse(benchmark::State &state) {
+    std::string message;
+    MakeUpdateRequest().SerializeToString(&message);
+    for (auto _ : state) {
+        hello_ipc::Request req;
+        benchmark::DoNotOptimize(req.ParseFromString(message));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestParse);
+
+static void BM_RequestParseLedId(benchmark::State &state) {
+    std::string message;
+    MakeUpdateRequest(true).SerializeToString(&message);
+    for (auto _ : state) {
+        hello_ipc::Request req;
+        benchmark::DoNotOptimize(req.ParseFromString(message));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestParseLedId);
+
+static void BM_RequestParseArena(benchmark::State &state) {
+    std::string message;
+    MakeUpdateRequest().SerializeToString(&message);
+    alignas(8) static char block[16 * 1024];
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = sizeof(block);
+    google::protobuf::Arena arena(options);
+    for (auto _ : state) {
+        arena.Reset();
+        auto *req = google::protobuf::Arena::CreateMessage<hello_ipc::Request>(&arena);
+        benchmark::DoNotOptimize(req->ParseFromArray(message.data(), static_cast<int>(message.size())));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestParseArena);
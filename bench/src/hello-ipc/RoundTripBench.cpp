@@ -0,0 +1,90 @@
+#include "LedManager.hpp"
+#include "led_service.pb.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+// --- End-to-end UpdateLed -> LedManager round trips over the Unix socket ---
+
+namespace {
+
+const char *const kBenchSocketPath = "/tmp/hello_ipc_bench.sock";
+
+class BenchServer : public hello_ipc::LedManager {
+public:
+    using hello_ipc::LedManager::StopServer;
+};
+
+class BenchClient : public hello_ipc::Service {
+public:
+    BenchClient() : hello_ipc::Service("UpdateLedBench", false) {}
+    using hello_ipc::Service::ConnectToServer;
+};
+
+// LedManager running on a background thread for the lifetime of the process.
+class ServerFixture {
+public:
+    ServerFixture() : thread_([this]() { server_.Run(kBenchSocketPath); }) {}
+
+    ~ServerFixture() {
+        server_.StopServer();
+        thread_.join();
+    }
+
+    static ServerFixture &Instance() {
+        static ServerFixture fixture;
+        return fixture;
+    }
+
+private:
+    BenchServer server_;
+    std::thread thread_;
+};
+
+// Connects a client, retrying while the server thread is still starting up.
+bool ConnectWithRetry(BenchClient &client) {
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (client.ConnectToServer(kBenchSocketPath)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+} // namespace
+
+static void BM_UpdateRoundTrip(benchmark::State &state) {
+    ServerFixture::Instance();
+    BenchClient client;
+    if (!ConnectWithRetry(client)) {
+        state.SkipWithError("Failed to connect to the LedManager");
+        return;
+    }
+
+    hello_ipc::Request req;
+    auto *update_req = req.mutable_update_request();
+    update_req->set_led_id(static_cast<uint32_t>(1000 + state.thread_index()));
+    uint64_t request_id = 1;
+    std::string message;
+
+    for (auto _ : state) {
+        req.set_request_id(request_id++);
+        update_req->set_state((request_id & 1) ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+        req.SerializeToString(&message);
+        client.SendMessage(message);
+
+        auto response = client.ReceiveMessage();
+        if (!response) {
+            state.SkipWithError("Failed to receive a response");
+            break;
+        }
+        benchmark::DoNotOptimize(response->data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateRoundTrip)->Threads(1)->Threads(8)->Threads(64)->UseRealTime();
@@ -0,0 +1,58 @@
+#ifndef HELLO_IPC_COMPACT_MESSAGE_HPP_
+#define HELLO_IPC_COMPACT_MESSAGE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace hello_ipc {
+
+/**
+ * @file CompactMessage.hpp
+ * @brief Fixed-layout alternative to the protobuf messages for single LED requests.
+ *
+ * A client selects this encoding with a handshake byte when it connects (see
+ * Service::SetWireFormat()); protobuf stays the default. Every request and
+ * response is exactly kCompactMessageSize bytes inside the usual length-prefixed
+ * frame, with integers in network byte order:
+ *
+ *   byte 0      opcode
+ *   byte 1      state, 1 for on
+ *   byte 2      error code of a kError response
+ *   byte 3      reserved, 0
+ *   bytes 4-7   LED id
+ *   bytes 8-15  request id, echoed in the response
+ */
+const std::size_t kCompactMessageSize = 16;
+
+enum class CompactOpcode : uint8_t {
+    kUpdate = 1, // Request: set the LED to state
+    kQuery = 2,  // Request: read the LED state
+    kState = 3,  // Response: state holds the LED state
+    kError = 4   // Response: error holds the reason
+};
+
+enum class CompactError : uint8_t {
+    kNone = 0,
+    kNotFound = 1,  // The LED has no brightness file
+    kBadRequest = 2, // The message is not a request
+    kOverloaded = 3  // Not handled, the client had too many requests in flight
+};
+
+struct CompactMessage {
+    CompactOpcode opcode = CompactOpcode::kQuery;
+    bool on = false;
+    CompactError error = CompactError::kNone;
+    uint32_t led_id = 0;
+    uint64_t request_id = 0;
+};
+
+// Writes kCompactMessageSize bytes to out.
+void EncodeCompactMessage(const CompactMessage &message, char *out);
+
+// Returns false if data is not exactly one message with a known opcode.
+bool DecodeCompactMessage(std::string_view data, CompactMessage *message);
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_COMPACT_MESSAGE_HPP_
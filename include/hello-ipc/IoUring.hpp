@@ -0,0 +1,103 @@
+#ifndef HELLO_IPC_IO_URING_HPP_
+#define HELLO_IPC_IO_URING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace hello_ipc {
+
+/**
+ * @file IoUring.hpp
+ * @brief Minimal wrapper around a Linux io_uring instance.
+ *
+ * Talks to the kernel interface directly, so no liburing is needed. Only the
+ * operations used by the Service io_uring backend are exposed: multishot accept,
+ * multishot recv into a provided buffer ring, linked sends, reads and cancel.
+ *
+ * Any thread may queue and submit requests; completions must be reaped by a
+ * single thread.
+ *
+ * @throws std::runtime_error if the ring cannot be created.
+ */
+class IoUring {
+    public:
+        struct Completion {
+            uint64_t user_data;
+            int32_t res;
+            uint32_t flags;
+        };
+
+        explicit IoUring(unsigned entries);
+        ~IoUring();
+
+        IoUring(const IoUring &) = delete;
+        IoUring &operator=(const IoUring &) = delete;
+
+        // Registers a ring of count buffers of size bytes each under group_id.
+        bool SetupBufferRing(uint16_t group_id, uint16_t count, uint32_t size);
+        // Whether the kernel supports multishot recv into the buffer ring of group_id.
+        bool ProbeMultishotRecv(uint16_t group_id);
+        const char *BufferData(uint16_t buffer_id) const;
+        void RecycleBuffer(uint16_t buffer_id);
+
+        // Request preparation. The requests are sent to the kernel by the next Submit*().
+        // Each returns false without queueing anything if the submission queue is full and
+        // the kernel does not take the queued requests.
+        bool QueueMultishotAccept(int fd, uint64_t user_data);
+        bool QueueMultishotRecv(int fd, uint16_t group_id, uint64_t user_data);
+        bool QueueRead(int fd, void *buf, std::size_t len, uint64_t user_data);
+        bool QueueLinkedSend(int fd, const void *head, std::size_t head_len, uint64_t head_user_data,
+                             const void *body, std::size_t body_len, uint64_t body_user_data);
+        bool QueueCancelAll(uint64_t user_data);
+
+        // Sends queued requests and waits for at least wait_nr completions.
+        int Submit(unsigned wait_nr = 0);
+
+        // Copies up to max available completions into out and returns how many were reaped.
+        unsigned ReapCompletions(Completion *out, unsigned max);
+
+        static bool HasMore(uint32_t flags);
+        static bool HasBuffer(uint32_t flags);
+        static uint16_t BufferId(uint32_t flags);
+
+    private:
+        void Release();
+        bool MakeRoom(unsigned count);
+        void *NextSqe();
+        void Publish();
+        int Enter(unsigned to_submit, unsigned wait_nr);
+
+        int ring_fd_;
+
+        void *sq_ring_ptr_;
+        std::size_t sq_ring_size_;
+        void *cq_ring_ptr_;
+        std::size_t cq_ring_size_;
+        void *sqes_ptr_;
+        std::size_t sqes_size_;
+
+        unsigned *sq_head_;
+        unsigned *sq_tail_;
+        unsigned *sq_mask_;
+        unsigned *sq_array_;
+        unsigned sq_entries_;
+        unsigned sq_local_tail_;
+        unsigned *cq_head_;
+        unsigned *cq_tail_;
+        unsigned *cq_mask_;
+        void *cqes_;
+
+        std::mutex sq_mutex_; // Held while entries are prepared and submitted, never while waiting
+
+        void *buf_ring_;
+        std::size_t buf_ring_size_;
+        uint16_t buf_count_;
+        uint32_t buf_size_;
+        std::vector<char> buffers_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_IO_URING_HPP_
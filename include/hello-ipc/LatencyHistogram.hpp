@@ -0,0 +1,49 @@
+#ifndef HELLO_IPC_LATENCY_HISTOGRAM_HPP_
+#define HELLO_IPC_LATENCY_HISTOGRAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hello_ipc {
+
+/**
+ * @file LatencyHistogram.hpp
+ * @brief HDR-style histogram of non-negative integer values, usually nanoseconds.
+ *
+ * Values are counted in log-linear buckets: every power of two range is split into
+ * 128 equal sub-buckets, so any recorded value is reported with less than 1% error
+ * over the whole uint64_t range at a fixed memory cost.
+ *
+ * Not thread safe; give every thread its own histogram and Merge() them.
+ */
+class LatencyHistogram {
+    public:
+        LatencyHistogram();
+
+        void Record(uint64_t value);
+        void Merge(const LatencyHistogram &other);
+        void Reset();
+
+        // Smallest recorded bucket value at or above the given percentile (0-100), 0 if empty.
+        uint64_t Percentile(double percentile) const;
+
+        uint64_t count() const { return count_; }
+        uint64_t min() const { return count_ > 0 ? min_ : 0; }
+        uint64_t max() const { return max_; }
+        double mean() const { return count_ > 0 ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    private:
+        static std::size_t BucketIndex(uint64_t value);
+        static uint64_t BucketUpperBound(std::size_t index);
+
+        std::vector<uint64_t> buckets_;
+        uint64_t count_;
+        uint64_t min_;
+        uint64_t max_;
+        uint64_t sum_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_LATENCY_HISTOGRAM_HPP_
@@ -0,0 +1,65 @@
+#ifndef HELLO_IPC_LED_FILE_CACHE_HPP_
+#define HELLO_IPC_LED_FILE_CACHE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace hello_ipc {
+
+/**
+ * @file LedFileCache.hpp
+ * @brief LRU-bounded cache of open LED brightness file descriptors.
+ *
+ * Keeps <root>/led_<id>/brightness open so an update is a single pwrite and a
+ * read a single pread at offset 0, the access pattern of sysfs attributes. An
+ * entry whose access fails, as on a sysfs attribute whose device went away, is
+ * dropped and the file reopened once. Regular files stay accessible after they
+ * are unlinked, so entries are also checked for that every stale_check_interval.
+ *
+ * All methods are thread safe.
+ */
+class LedFileCache {
+    public:
+        explicit LedFileCache(std::size_t capacity = 64, const std::string &root = "/tmp/sys/class",
+                              std::chrono::milliseconds stale_check_interval = std::chrono::seconds(1));
+        ~LedFileCache();
+
+        LedFileCache(const LedFileCache &) = delete;
+        LedFileCache &operator=(const LedFileCache &) = delete;
+
+        // Writes "<value>\n" to the brightness file, creating it if needed.
+        bool Write(uint32_t led_id, char value);
+
+        // Reads the first byte of the brightness file. Returns false if the file does not exist.
+        bool Read(uint32_t led_id, char *value);
+
+        std::size_t size() const;
+
+    private:
+        struct Entry {
+            uint32_t led_id;
+            int fd;
+            std::chrono::steady_clock::time_point checked; // Last time the file was known to be linked
+        };
+
+        int Acquire(uint32_t led_id, bool create);
+        void Evict(std::list<Entry>::iterator it);
+        std::string LedDirectory(uint32_t led_id) const;
+
+        const std::size_t capacity_;
+        const std::string root_;
+        const std::chrono::milliseconds stale_check_interval_;
+
+        mutable std::mutex mutex_;
+        std::list<Entry> lru_; // Most recently used first
+        std::unordered_map<uint32_t, std::list<Entry>::iterator> entries_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_LED_FILE_CACHE_HPP_
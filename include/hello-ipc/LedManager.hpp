@@ -1,11 +1,26 @@
 #ifndef HELLO_IPC_LED_MANAGER_HPP_
 #define HELLO_IPC_LED_MANAGER_HPP_
 
+#include "CompactMessage.hpp"
+#include "LedFileCache.hpp"
+#include "LedStateStore.hpp"
 #include "Service.hpp"
 #include "led_service.pb.h"
 
-#include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 namespace hello_ipc {
 
 /**
@@ -13,7 +28,27 @@ namespace hello_ipc {
  * @brief Class to manage LED states via IPC.
  *
  * This class provides methods to update the state of an LED based on received messages.
- * It handles the creation of directories and writing to files representing LED states.
+ * The LED states live in an in-memory table keyed by the numeric LED id, which serves
+ * every query. The table is split into shards by LED id, each with its own lock, so
+ * requests for different LEDs rarely contend while requests for the same LED are
+ * serialized. Updates are written back to the brightness files by a single flusher
+ * thread, which coalesces repeated updates of the same LED into one write. The
+ * brightness files are kept open in a LedFileCache.
+ *
+ * Queries and stats requests run in the server's interactive lane and every other
+ * request in the bulk lane, each with its own workers, so a query never waits behind
+ * another client's large batch update; the Request priority field overrides the choice.
+ * A client's own requests are always handled in the order they arrived.
+ *
+ * Optionally the table survives restarts: EnableStateStore() restores it from a
+ * LedStateStore snapshot and journal, the flusher journals every batch it writes,
+ * and checkpoints replace the snapshot periodically and when the server stops.
+ *
+ * Clients may subscribe to LED changes. Committed updates are pushed to the
+ * matching subscribers by a notifier thread, so an update never waits for a
+ * subscriber, and the notifier never waits for a subscriber either: changes a
+ * slow subscriber cannot take yet collapse into the latest state of each LED in
+ * its own backlog, and a subscriber that stops reading is eventually dropped.
  * 
  * @param socket_path The path to the socket file for communication.
  * @throws std::runtime_error if the socket connection fails or file operations fail.
@@ -23,14 +58,94 @@ namespace hello_ipc {
 class LedManager : public Service {
     public:
         LedManager();
+        ~LedManager();
         void Run(const std::string &socket_path);
 
+        // Makes Run() return after the current events. Async-signal-safe.
+        void Stop() { StopServer(); }
+
+        // Writes every pending state change to the brightness files before returning.
+        void Flush();
+
+        // Replaces the snapshot with every state already written to the brightness files and
+        // empties the journal. Does nothing without a state store.
+        void Checkpoint();
+
+        // Restores the LED table from snapshot_path and its journal and keeps them up to date.
+        // Call before Run(). Returns false, running without persistence, if the files are unusable.
+        bool EnableStateStore(const std::string &snapshot_path);
+
     protected:
-        void HandleMessage(int client_socket, const std::string &message);
+        struct Subscription;
+
+        void HandleMessage(int client_socket, std::string_view message);
+        void HandleCompactMessage(int client_socket, std::string_view message);
+        void HandleCompactRequest(const CompactMessage &req, CompactMessage *res);
         bool UpdateLedState(const std::string &led_num, hello_ipc::LedState led_state);
+        bool UpdateLedState(uint32_t led_id, hello_ipc::LedState led_state);
+        bool StoreLedState(const std::string &led_num, hello_ipc::LedState led_state, bool *changed = nullptr);
+        bool StoreLedState(uint32_t led_id, hello_ipc::LedState led_state, bool *changed = nullptr);
         void HandleUpdateRequest(const LedUpdateRequest &req, LedStateResponse *res);
         void HandleQueryRequest(const LedQueryRequest &req, LedStateResponse *res);
+        void HandleBatchUpdateRequest(const BatchUpdateRequest &req, BatchStateResponse *res);
+        void HandleBatchQueryRequest(const BatchQueryRequest &req, BatchStateResponse *res);
+        void HandleStatsRequest(const StatsRequest &req, StatsResponse *res);
+        std::shared_ptr<Subscription> HandleSubscribeRequest(int client_socket, uint64_t request_id,
+                                                             const SubscribeRequest &req, SubscribeResponse *res);
+        void HandleCompareAndSetRequest(const CompareAndSetRequest &req, CompareAndSetResponse *res);
+        Lane ClassifyMessage(std::string_view message, WireFormat wire_format) const override;
+        std::optional<std::string> OverloadedResponse(std::string_view message, WireFormat wire_format) const override;
+        void OnClientDisconnected(int client_socket) override;
         std::string GetLedState(const std::string &led_num) const;
+
+    private:
+
+        static constexpr std::size_t kShardCount = 16;
+
+        // One partition of the LED table, on its own cache line so shards do not share one
+        struct alignas(64) Shard {
+            std::mutex mutex;
+            std::unordered_map<uint32_t, hello_ipc::LedState> leds;
+            std::unordered_map<uint32_t, hello_ipc::LedState> dirty; // Not written to the files yet
+        };
+
+        Shard &ShardFor(uint32_t led_id) const { return shards_[led_id % kShardCount]; }
+
+        bool CommitLedState(uint32_t led_id, hello_ipc::LedState led_state);
+        std::optional<hello_ipc::LedState> CompareAndSetLedState(uint32_t led_id, hello_ipc::LedState expected,
+                                                                 hello_ipc::LedState desired, bool *changed = nullptr);
+        void PublishChange(uint32_t led_id, hello_ipc::LedState led_state, bool shard_was_clean);
+        std::optional<hello_ipc::LedState> LookupLedState(uint32_t led_id) const;
+        bool LoadLedState(uint32_t led_id, hello_ipc::LedState *led_state) const;
+        bool WriteBrightnessFile(uint32_t led_id, hello_ipc::LedState led_state);
+        void WritePendingStates();
+        void WriteCheckpoint();
+        void FlushLoop();
+        void QueueNotification(uint32_t led_id, hello_ipc::LedState led_state);
+        void NotifyLoop();
+        bool SendNotifications(const std::unordered_map<uint32_t, hello_ipc::LedState> &changes,
+                               const std::vector<std::shared_ptr<Subscription>> &subscriptions);
+        void AddSubscription(std::shared_ptr<Subscription> subscription);
+        void DropSubscription(const std::shared_ptr<Subscription> &subscription);
+
+        mutable LedFileCache files_;
+        mutable std::array<Shard, kShardCount> shards_;
+        std::mutex flush_mutex_;
+        bool flush_pending_ = false; // A shard went from clean to dirty since the last flush started
+        bool stopping_ = false;
+        std::condition_variable flush_cv_;
+        std::mutex write_mutex_;
+        std::unique_ptr<LedStateStore> store_; // Guarded by write_mutex_, null without persistence
+        std::chrono::steady_clock::time_point last_checkpoint_;
+        std::thread flusher_;
+
+        std::mutex notify_mutex_;
+        std::condition_variable notify_cv_;
+        std::unordered_map<int, std::shared_ptr<Subscription>> subscriptions_; // By client socket
+        std::atomic<std::size_t> subscription_count_{0}; // Lets updates skip the notifier without locking
+        std::unordered_map<uint32_t, hello_ipc::LedState> changes_; // Not yet pushed, latest state per LED
+        bool notifier_stopping_ = false;
+        std::thread notifier_;
 };
 
 } // namespace hello_ipc
@@ -0,0 +1,72 @@
+#ifndef HELLO_IPC_LED_STATE_STORE_HPP_
+#define HELLO_IPC_LED_STATE_STORE_HPP_
+
+#include "led_service.pb.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hello_ipc {
+
+/**
+ * @file LedStateStore.hpp
+ * @brief Snapshot file plus append-only journal of the LED table.
+ *
+ * The snapshot at <path> holds every known LED state as fixed 8-byte entries
+ * after a small header, so restoring it is one mmap and a linear pass. Changes
+ * made after the snapshot are appended to <path>.journal in the same entry
+ * format. A checkpoint writes a new snapshot next to the old one, renames it
+ * over it and starts an empty journal.
+ *
+ * Snapshot and journal carry a generation number. A journal is only replayed
+ * on top of the snapshot of the same generation, so a crash between renaming a
+ * new snapshot and resetting the journal cannot replay stale changes. A journal
+ * entry cut short by a crash is dropped on the next Open().
+ *
+ * The files use the host byte order; they are a local cache, not an exchange
+ * format. The class is not thread safe.
+ */
+class LedStateStore {
+    public:
+        // journaled is set for the changes made after the snapshot, which may not have reached the LEDs
+        using RestoreCallback = std::function<void(uint32_t led_id, hello_ipc::LedState led_state, bool journaled)>;
+
+        explicit LedStateStore(const std::string &snapshot_path);
+        ~LedStateStore();
+
+        LedStateStore(const LedStateStore &) = delete;
+        LedStateStore &operator=(const LedStateStore &) = delete;
+
+        // Replays the snapshot and then the journal, and opens the journal for appending.
+        // Returns false, leaving the files untouched, if they are unreadable or corrupt.
+        bool Open(const RestoreCallback &restore, std::string *error);
+
+        // Appends the changes to the journal with a single write.
+        bool Append(const std::unordered_map<uint32_t, hello_ipc::LedState> &changes);
+
+        // Replaces the snapshot with states and empties the journal.
+        bool Checkpoint(const std::vector<std::pair<uint32_t, hello_ipc::LedState>> &states);
+
+        std::size_t journal_entries() const { return journal_entries_; }
+        const std::string &snapshot_path() const { return snapshot_path_; }
+
+    private:
+        bool ReplaySnapshot(const RestoreCallback &restore, std::string *error);
+        bool ReplayJournal(const RestoreCallback &restore, std::string *error);
+        bool ResetJournal();
+
+        const std::string snapshot_path_;
+        const std::string journal_path_;
+        uint64_t generation_ = 0;
+        int journal_fd_ = -1;
+        std::size_t journal_entries_ = 0;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_LED_STATE_STORE_HPP_
@@ -0,0 +1,67 @@
+#ifndef HELLO_IPC_LOAD_GENERATOR_HPP_
+#define HELLO_IPC_LOAD_GENERATOR_HPP_
+
+#include "LatencyHistogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace hello_ipc {
+
+/**
+ * @file LoadGenerator.hpp
+ * @brief Drives a LedManager with a configurable mix of update and query requests.
+ *
+ * Every connection runs on its own thread and uses the regular Service framing.
+ * In closed-loop mode each connection sends its next request as soon as the
+ * previous response arrived. In open-loop mode requests are scheduled at a fixed
+ * total rate and latency is measured from the scheduled send time, so a server
+ * that falls behind is not hidden by the client slowing down.
+ *
+ * LED numbers are drawn from [0, keys) with a Zipf distribution; a skew of 0
+ * picks them uniformly. With compact set the connections negotiate the
+ * fixed-size CompactMessage encoding instead of protobuf.
+ */
+class LoadGenerator {
+    public:
+        struct Options {
+            std::size_t connections = 4;
+            double update_ratio = 0.5;  // Fraction of requests that are updates, the rest are queries
+            uint32_t keys = 1024;
+            double zipf_skew = 0.0;
+            double rate = 0.0;          // Total requests per second, 0 runs closed-loop
+            double duration_s = 10.0;
+            bool compact = false;       // Use the CompactMessage wire format
+        };
+
+        struct Report {
+            uint64_t requests = 0;
+            uint64_t errors = 0;
+            double elapsed_s = 0.0;
+            LatencyHistogram latency_ns;
+        };
+
+        // Parses "--connections N --update-ratio R --keys K --zipf S --rate R --duration S --compact".
+        static bool ParseArguments(int argc, char **argv, Options *options);
+
+        LoadGenerator(const std::string &socket_path, const Options &options);
+
+        // Runs the load for the configured duration. Returns false if no connection could be made.
+        bool Run();
+
+        const Report &report() const { return report_; }
+        void PrintReport(std::ostream &out) const;
+
+    private:
+        void RunConnection(std::size_t index, Report *report);
+
+        std::string socket_path_;
+        Options options_;
+        Report report_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_LOAD_GENERATOR_HPP_
@@ -0,0 +1,101 @@
+#ifndef HELLO_IPC_LOG_RECORD_HPP_
+#define HELLO_IPC_LOG_RECORD_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace hello_ipc {
+
+/**
+ * @file LogRecord.hpp
+ * @brief Structured log records: a static format id plus raw argument bytes.
+ *
+ * Callers log a LogId and its arguments instead of a formatted string. The
+ * arguments are copied as tagged raw bytes and the text is only produced when
+ * the record is written as text, or offline by hello_ipc_logdump for binary logs.
+ *
+ * A record is laid out as [uint16 format id][uint64 timestamp ns][arguments],
+ * where every argument is a tag byte followed by its value: 'i' int64, 'u' uint64,
+ * or 's' uint16 length and the string bytes. Values are stored in host byte order.
+ */
+
+// Format ids are stored in binary logs, only ever append to this list.
+enum class LogId : uint16_t {
+    kMessage = 0,
+    kUpdateReceived,
+    kQueryReceived,
+    kLedUpdated,
+    kBatchUpdated,
+    kBatchQueryReceived,
+    kUpdateSent,
+    kUpdatesSent,
+    kQuerySent,
+    kStateResponseReceived,
+    kCount
+};
+
+// Largest encoded record, format id and timestamp included.
+const std::size_t kLogRecordMaxSize = 240;
+const std::size_t kLogRecordHeaderSize = sizeof(uint16_t) + sizeof(uint64_t);
+
+// Binary log files start with this magic, a uint16 service name length and the name.
+const char kBinaryLogMagic[8] = {'H', 'I', 'P', 'C', 'B', 'L', 'G', '1'};
+
+// Returns the format string of id, whose "{}" are replaced by the arguments, or nullptr.
+const char *LogFormatString(LogId id);
+
+/**
+ * @brief Fixed-size buffer of encoded log arguments.
+ *
+ * Arguments that do not fit are dropped; strings are truncated to the space left.
+ */
+class LogArgs {
+    public:
+        void Add(std::string_view value) {
+            if (size_ + 1 + sizeof(uint16_t) > sizeof(data_)) {
+                return;
+            }
+            uint16_t length = static_cast<uint16_t>(
+                std::min(value.size(), sizeof(data_) - size_ - 1 - sizeof(uint16_t)));
+            data_[size_++] = 's';
+            memcpy(data_ + size_, &length, sizeof(length));
+            memcpy(data_ + size_ + sizeof(length), value.data(), length);
+            size_ += sizeof(length) + length;
+        }
+        void Add(const std::string &value) { Add(std::string_view(value)); }
+        void Add(const char *value) { Add(std::string_view(value)); }
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+        void Add(T value) {
+            if (size_ + 1 + sizeof(uint64_t) > sizeof(data_)) {
+                return;
+            }
+            uint64_t raw = std::is_signed<T>::value ? static_cast<uint64_t>(static_cast<int64_t>(value))
+                                                    : static_cast<uint64_t>(value);
+            data_[size_++] = std::is_signed<T>::value ? 'i' : 'u';
+            memcpy(data_ + size_, &raw, sizeof(raw));
+            size_ += sizeof(raw);
+        }
+
+        const char *data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        char data_[kLogRecordMaxSize - kLogRecordHeaderSize];
+        std::size_t size_ = 0;
+};
+
+// Encodes a record into out, which must hold kLogRecordMaxSize bytes. Returns its size.
+std::size_t EncodeLogRecord(LogId id, uint64_t timestamp_ns, const LogArgs &args, char *out);
+
+// Appends the text of a record to out. Returns false if the record is malformed.
+bool FormatLogRecord(const char *record, std::size_t size, std::string &out, uint64_t *timestamp_ns = nullptr);
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_LOG_RECORD_HPP_
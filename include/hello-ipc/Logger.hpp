@@ -1,9 +1,12 @@
 #ifndef HELLO_IPC_LOGGER_HPP_
 #define HELLO_IPC_LOGGER_HPP_
 
+#include "LogRecord.hpp"
+
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <fstream>
 
 namespace hello_ipc {
 
@@ -13,33 +16,92 @@ namespace hello_ipc {
  *
  * This class provides methods to log messages to a specified log file.
  * It writes in the /tmp/<log-name>.log format and <log-name> is the name of the service ex: UpdateLed
+ *
+ * In synchronous mode every message is written with one write() call, so lines
+ * from concurrent callers never interleave. In asynchronous mode callers copy the
+ * message into a fixed-size record of a lock-free ring and return; a background
+ * thread writes the records in large batches. When the ring is full the record is
+ * dropped and counted instead of blocking the caller.
+ *
+ * Structured messages, a LogId plus arguments, are only formatted when written,
+ * by the background thread in async mode. In binary format they are never
+ * formatted at all: /tmp/<log-name>.binlog receives the raw records with a
+ * timestamp, to be decoded offline by hello_ipc_logdump.
  */
 class Logger {
     public:
+        enum class Mode {
+            kSync,
+            kAsync
+        };
+
+        enum class Format {
+            kText,   // "[<log-name>]: message" lines in /tmp/<log-name>.log
+            kBinary  // Encoded records in /tmp/<log-name>.binlog
+        };
+
         /**
          * @brief Constructs a Logger for the given service name.
          * @param service_name The name of the service (used for the log file name).
+         * @param mode Whether messages are written by the caller or by a background thread.
+         * @param format Whether messages are written as text lines or binary records.
          */
-        explicit Logger(const std::string &service_name);
+        explicit Logger(const std::string &service_name, Mode mode = Mode::kSync,
+                        Format format = Format::kText);
 
         /**
          * @brief Logs a message to the log file.
-         * @param message The message to log.
+         * @param message The message to log. In async mode long messages are truncated.
          */
         void Log(const std::string &message) const;
 
         /**
-         * @brief Destructor closes the log file.
+         * @brief Logs a structured message, formatted only when it is written as text.
+         * @param id The format string id.
+         * @param args Strings and integers replacing the "{}" of the format string.
+         */
+        template <typename... Args>
+        void Log(LogId id, const Args &...args) const {
+            LogArgs encoded;
+            (encoded.Add(args), ...);
+            LogRecord(id, encoded);
+        }
+
+        /**
+         * @brief Waits until every message logged before the call is written.
+         */
+        void Flush() const;
+
+        /**
+         * @brief Number of messages dropped because the async ring was full.
+         */
+        uint64_t dropped() const;
+
+        /**
+         * @brief Destructor writes the pending messages and closes the log file.
          */
         ~Logger();
 
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
+
     private:
+        struct AsyncRing;
+
         void OpenLogFile(const std::string &service_name);
+        void LogRecord(LogId id, const LogArgs &args) const;
+        void AppendRecord(const char *record, std::size_t size, std::string &out) const;
+        void WriteLine(const char *message, std::size_t length) const;
+        void WriterLoop();
+
         std::string log_file_path_;
         std::string service_name_;
-        mutable std::ofstream log_file_;
+        std::string prefix_;
+        Format format_;
+        int log_fd_;
+        std::unique_ptr<AsyncRing> async_;
 };
 
 } // namespace hello_ipc
 
-#endif // HELLO_IPC_LOGGER_HPP_
\ No newline at end of file
+#endif // HELLO_IPC_LOGGER_HPP_
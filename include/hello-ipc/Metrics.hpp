@@ -0,0 +1,89 @@
+#ifndef HELLO_IPC_METRICS_HPP_
+#define HELLO_IPC_METRICS_HPP_
+
+#include "LatencyHistogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hello_ipc {
+
+/**
+ * @file Metrics.hpp
+ * @brief Runtime counters and per-stage latency histograms of a server.
+ *
+ * Every thread that records gets its own shard, so recording never touches a
+ * cache line shared with another thread. Read() merges all shards into a
+ * snapshot; it is the only operation that takes shard locks held by others.
+ */
+class Metrics {
+    public:
+        enum Counter {
+            kUpdateRequests,
+            kQueryRequests,
+            kBatchUpdateRequests,
+            kBatchQueryRequests,
+            kStatsRequests,
+            kSubscribeRequests,
+            kCompareAndSetRequests,
+            kNotificationsSent, // LED changes pushed to subscribers
+            kNoOpUpdates,       // Updates to the state the LED already had, not written
+            kParseFailures,
+            kBytesIn,
+            kBytesOut,
+            kActiveConnections, // Incremented on accept and decremented on disconnect
+            kRejectedConnections, // Closed on accept because the server had max_connections clients
+            kOverloadedRequests,  // Answered as overloaded because the client had max_in_flight queued
+            kCounterCount
+        };
+
+        enum Stage {
+            kRecv,      // Reading requests off the transport, not seen by the io_uring backend
+            kParse,
+            kHandle,
+            kSerialize,
+            kSend,      // Writing or, with io_uring, queueing a response
+            kStageCount
+        };
+
+        struct Snapshot {
+            std::array<uint64_t, kCounterCount> counters{};
+            std::array<LatencyHistogram, kStageCount> stages;
+        };
+
+        Metrics();
+        ~Metrics();
+
+        Metrics(const Metrics &) = delete;
+        Metrics &operator=(const Metrics &) = delete;
+
+        void Add(Counter counter, int64_t delta = 1);
+        void RecordLatency(Stage stage, uint64_t nanoseconds);
+
+        // Records the time elapsed since start_ns, a value returned by Now().
+        void RecordSince(Stage stage, uint64_t start_ns) { RecordLatency(stage, Now() - start_ns); }
+
+        Snapshot Read() const;
+
+        static const char *StageName(Stage stage);
+
+        // Monotonic clock in nanoseconds.
+        static uint64_t Now();
+
+    private:
+        struct Shard;
+
+        Shard &LocalShard();
+
+        const uint64_t id_; // Never reused, so a thread's cached shard of a destroyed instance is never found
+        mutable std::mutex shards_mutex_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_METRICS_HPP_
@@ -3,7 +3,10 @@
 
 #include "Service.hpp"
 
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace hello_ipc {
 
@@ -22,9 +25,18 @@ class QueryLed : public Service {
         QueryLed(const std::string &socket_path, bool connect = true);
         void Run();
 
+        // Fetches the server's runtime metrics and prints them to out.
+        bool QueryStats(std::ostream &out);
+
+        // Subscribes to changes of the given LEDs (all if empty) and prints every change to out.
+        // Returns after max_changes changes, or when the connection ends if max_changes is 0.
+        bool Watch(const std::vector<std::string> &led_nums, std::ostream &out, int max_changes = 0);
+
     protected:
         void HandleUserInput(std::istream &input_stream);
         void queryState(const std::string &led_name);
+
+        uint64_t next_request_id_;
 };
 
 } // namespace hello_ipc
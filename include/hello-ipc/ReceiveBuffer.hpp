@@ -0,0 +1,60 @@
+#ifndef HELLO_IPC_RECEIVE_BUFFER_HPP_
+#define HELLO_IPC_RECEIVE_BUFFER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace hello_ipc {
+
+/**
+ * @file ReceiveBuffer.hpp
+ * @brief Growable read buffer whose frames can be handed out without copying.
+ *
+ * Bytes are received straight into the free space at the end of a reference
+ * counted block. Complete frames are passed on as views into the block; whoever
+ * keeps such a view also keeps a Pin() of the block, so the buffer never rewrites
+ * bytes that are still being read. When the block runs out of space the unread
+ * tail is moved to the front of an unpinned block: the current one if nobody else
+ * holds it, otherwise a spare that is kept around so the steady state does not
+ * allocate.
+ *
+ * Not thread safe, except that pins may be released from any thread.
+ */
+class ReceiveBuffer {
+    public:
+        explicit ReceiveBuffer(std::size_t block_size = 16384);
+
+        // Returns the free space at the end, making room for at least min_free bytes.
+        char *Reserve(std::size_t min_free);
+        std::size_t writable() const { return capacity_ - end_; }
+
+        // Marks count bytes written after Reserve() as received.
+        void Commit(std::size_t count) { end_ += count; }
+
+        // Copies bytes in, for sources that cannot write into Reserve() directly.
+        void Append(const char *data, std::size_t count);
+
+        std::string_view readable() const { return std::string_view(block_.get() + begin_, end_ - begin_); }
+        void Consume(std::size_t count) { begin_ += count; }
+        void Clear() { begin_ = end_ = 0; }
+
+        bool empty() const { return begin_ == end_; }
+        std::size_t size() const { return end_ - begin_; }
+
+        // Keeps the current block, and every view into it, alive.
+        std::shared_ptr<const char[]> Pin() const { return block_; }
+
+    private:
+        std::size_t block_size_;
+        std::shared_ptr<char[]> block_;
+        std::shared_ptr<char[]> spare_;
+        std::size_t spare_capacity_;
+        std::size_t capacity_;
+        std::size_t begin_;
+        std::size_t end_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_RECEIVE_BUFFER_HPP_
@@ -2,10 +2,21 @@
 #define HELLO_IPC_SERVICE_HPP_
 
 #include "Logger.hpp"
+#include "Metrics.hpp"
+#include "ReceiveBuffer.hpp"
 
+#include <atomic>
 #include <string>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/uio.h>
 
 namespace hello_ipc {
 
@@ -19,14 +30,56 @@ namespace hello_ipc {
  * @param service_name The name of the service for logging purposes.
  * @throws std::runtime_error if the socket connection fails or sending/receiving messages fails.
  */
+class IoUring;
+class ShmChannel;
+class WorkerPool;
+
 class Service {
     public:
-        explicit Service(const std::string &service_name, bool connect = true);
+        // Kernel interface used by RunServer to wait for client traffic.
+        enum class ServerBackend {
+            kEpoll,   // Edge-triggered epoll readiness loop (default)
+            kIoUring  // io_uring completions: multishot accept/recv, linked sends
+        };
+
+        // Encoding of the messages inside the frames, negotiated when a client connects.
+        enum class WireFormat {
+            kProtobuf, // led_service.proto messages (default)
+            kCompact   // Fixed-size CompactMessage structs for single updates and queries
+        };
+
+        // Worker lanes of a server. Each lane has its own worker pool, so messages in one lane
+        // never wait for messages in the other. A client's messages are handled in arrival order:
+        // while it has messages queued in one lane, its next messages go to that lane as well.
+        enum class Lane {
+            kInteractive, // Cheap, latency-sensitive messages
+            kBulk         // Everything else (default)
+        };
+
+        // Admission control of a server. 0 means unlimited.
+        struct ServerLimits {
+            int backlog = 128;               // Connections the kernel queues until they are accepted
+            std::size_t max_connections = 0; // Clients served at once, further ones are closed on accept
+            int max_in_flight = 0;           // Messages of one client queued or being handled
+        };
+
+        explicit Service(const std::string &service_name, bool connect = true,
+                         Logger::Mode log_mode = Logger::Mode::kSync);
         virtual ~Service();
 
+        // For servers: selects the backend used by the next RunServer call.
+        // Falls back to epoll if io_uring is not compiled in or not supported by the kernel.
+        void SetServerBackend(ServerBackend backend) { server_backend_ = backend; }
+
+        // For servers: sets the limits used by the next RunServer call.
+        void SetServerLimits(const ServerLimits &limits) { limits_ = limits; }
+
         // For clients: sends a message.
         virtual void SendMessage(const std::string &message) const;
 
+        // For clients: sends several messages at once, coalesced into a single gathered write.
+        virtual void SendMessages(const std::vector<std::string> &messages) const;
+
         // For clients: receives a message.
         virtual std::optional<std::string> ReceiveMessage();
 
@@ -34,27 +87,129 @@ class Service {
         // For clients: connects to a server at a given socket path.
         bool ConnectToServer(const std::string &socket_path);
 
-        // For servers: runs a multi-threaded server loop.
+        // For clients: how long ReceiveMessage() waits, 0 waits forever. Defaults to 5 seconds.
+        void SetReceiveTimeout(int timeout_ms);
+
+        // For clients: selects the encoding requested by the next ConnectToServer call.
+        void SetWireFormat(WireFormat wire_format) { wire_format_ = wire_format; }
+
+        // For servers: runs an event loop that hands framed messages to a worker pool.
+        // The message view points into the receive buffer and is only valid during the call.
         void RunServer(const std::string &socket_path,
-                    const std::function<void(int, const std::string&)>& message_handler);
+                    const std::function<void(int, std::string_view)>& message_handler);
+
+        // For servers: makes a running RunServer loop return, or the next one if none is running yet.
+        // Safe to call from any thread and from signal handlers.
+        void StopServer();
 
-        // For servers: sends a response back to a specific client.
+        // For servers: sends a response back to a specific client. Safe to call from any thread.
         void SendResponse(int client_socket, const std::string& message) const;
 
+        // For servers: sends the responses held back to batch them with later ones, on the worker
+        // thread handling a message. Responses sent before then reach the client ahead of anything
+        // other threads send to it afterwards.
+        void FlushHeldResponses() const;
+
+        // For servers: whether the message being handled on this worker thread is a CompactMessage.
+        bool ClientUsesCompactFormat() const;
+
+        // For servers: messages queued or being handled per connected client, by client socket.
+        std::vector<std::pair<int, int>> ClientQueueDepths() const;
+
+        // For servers: bytes of responses the server holds because the client did not take them yet.
+        std::size_t UnsentBytes(int client_socket) const;
+
+        // For servers: keeps the client's descriptor from being closed and reused while the handle lives.
+        std::shared_ptr<const void> PinConnection(int client_socket) const;
+
+        // For servers: the answer to a message that arrived while the client had max_in_flight messages
+        // queued. Called on the event loop thread, which sends it right away instead of queueing the
+        // message, so it must be cheap. The default drops the message without an answer.
+        virtual std::optional<std::string> OverloadedResponse(std::string_view message, WireFormat wire_format) const {
+            (void)message;
+            (void)wire_format;
+            return std::nullopt;
+        }
+
+        // For servers: picks the lane of a message, on the event loop thread before the message
+        // is queued, so it must be cheap. The pick is ignored while the client still has messages
+        // queued in the other lane. The default puts every message in the bulk lane.
+        virtual Lane ClassifyMessage(std::string_view message, WireFormat wire_format) const {
+            (void)message;
+            (void)wire_format;
+            return Lane::kBulk;
+        }
+
+        // For servers: called by the event loop once a client is gone, before its descriptor is reused.
+        virtual void OnClientDisconnected(int client_socket) { (void)client_socket; }
+
         // For servers: creates a server socket and binds it to the specified path.
         int CreateServerSocket(const std::string &socket_path) const;
 
         const Logger &logger() const { return logger_; }
 
+        // For servers: runtime counters and latency histograms, filled in by the event loop.
+        Metrics &metrics() const { return metrics_; }
+
         // Getter for sockfd_
         void SetSocketFd(int fd) { sockfd_ = fd; }
         const int& GetSocket() const { return sockfd_; }
 
     private:
+        struct Connection;
+        struct LaneState;
+        static constexpr std::size_t kLaneCount = 2;
+        using MessageHandler = std::function<void(int, std::string_view)>;
+        using FrameCallback = std::function<void(std::string_view)>;
+
+        bool RequestCompactFormat();
+        bool SetupSharedMemory();
+        bool ReceiveSocketBytes();
+        bool ReceiveSharedMemoryBytes();
+        void RunEpollLoop(int server_fd, int wake_fd, const MessageHandler &message_handler);
+        bool RunIoUringLoop(int server_fd, int wake_fd, const MessageHandler &message_handler);
+        void AcceptClients(int server_fd, int epoll_fd);
+        bool AdmitConnection(int client_socket);
+        std::shared_ptr<Connection> AddConnection(int client_socket);
+        std::shared_ptr<Connection> FindConnection(int client_socket) const;
+        void RemoveConnection(int client_socket);
+        void Dispatch(WorkerPool *workers, const std::shared_ptr<Connection> &conn, std::string_view message,
+                    const MessageHandler &message_handler);
+        bool ReadHandshake(Connection &conn) const;
+        bool WatchSharedMemory(int epoll_fd, const std::shared_ptr<Connection> &conn);
+        bool ReadFrames(Connection &conn, const FrameCallback &on_message) const;
+        bool ReadSharedMemoryFrames(Connection &conn, const FrameCallback &on_message) const;
+        bool ExtractFrames(Connection &conn, const FrameCallback &on_message) const;
+        void FlushResponses(Connection &conn, LaneState &lane) const;
+        bool WriteToClient(Connection &conn, struct iovec *iov, std::size_t iovcnt) const;
+        void FlushUnsent(Connection &conn) const;
+        bool WriteAvailable(Connection &conn, struct iovec **iov, std::size_t *iovcnt) const;
+        bool SendResponseIoUring(int client_socket, const std::string &message) const;
+        bool SubmitNextSend(IoUring &ring, Connection &conn) const;
+        void OnSendComplete(IoUring &ring, Connection *conn, int result, bool stopping);
         void SetupSocketTimeout(int sockfd) const;
         Logger logger_;
+        mutable Metrics metrics_;
         int sockfd_;
-        std::string receive_buffer_;
+        ReceiveBuffer receive_buffer_; // Client side: bytes received but not yet returned
+        std::unique_ptr<ShmChannel> shm_; // Set when the client uses the shared memory transport
+        int receive_timeout_ms_;
+        WireFormat wire_format_;
+        std::atomic<int> wake_fd_;
+        std::atomic<bool> stop_requested_; // Latched by StopServer() until the loop returns
+        ServerBackend server_backend_;
+        ServerLimits limits_;
+        std::atomic<IoUring *> uring_; // Only set while the io_uring loop is running
+        mutable std::atomic<int> uring_users_; // Threads sending through uring_, waited for before teardown
+        mutable std::atomic<int> uring_sends_in_flight_;
+
+        mutable std::mutex connections_mutex_;
+        std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+        std::size_t client_count_ = 0; // Clients in connections_, which also maps their shared memory eventfds
+
+        // Connection whose message the current worker thread is handling
+        static thread_local Connection *current_connection_;
+        static thread_local Lane current_lane_; // Lane of the worker thread
 };
 
 } // namespace hello_ipc
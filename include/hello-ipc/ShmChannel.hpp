@@ -0,0 +1,90 @@
+#ifndef HELLO_IPC_SHM_CHANNEL_HPP_
+#define HELLO_IPC_SHM_CHANNEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hello_ipc {
+
+/**
+ * @file ShmChannel.hpp
+ * @brief Pair of single-producer/single-consumer byte rings in shared memory.
+ *
+ * A client creates the channel in a memfd and hands the memfd and two eventfds
+ * to the server over the Unix socket. The request ring carries client to server
+ * bytes and the response ring server to client bytes; both carry the same
+ * length-prefixed frames as the socket transport. A ring's eventfd is only
+ * signalled when the ring goes from empty to non-empty, so a busy peer is never
+ * woken by a syscall.
+ *
+ * The memfd is sealed against resizing, and Attach() refuses memory that is not,
+ * so a client cannot truncate the mapping under the server. The server writes
+ * with WriteSome(), which never waits for the client: a full ring marks the
+ * producer as stalled, and the consumer signals the producer's own eventfd once
+ * it made room.
+ *
+ * @throws std::runtime_error if the shared memory cannot be created or mapped.
+ */
+class ShmChannel {
+    public:
+        enum Direction {
+            kRequest = 0,  // Client writes, server reads
+            kResponse = 1  // Server writes, client reads
+        };
+
+        // Client side: creates a new channel whose rings hold ring_capacity bytes each.
+        static std::unique_ptr<ShmChannel> Create(std::size_t ring_capacity = 64 * 1024);
+
+        // Server side: maps a channel received from a client, taking ownership of the descriptors.
+        static std::unique_ptr<ShmChannel> Attach(int memfd, int request_event_fd, int response_event_fd);
+
+        ~ShmChannel();
+
+        ShmChannel(const ShmChannel &) = delete;
+        ShmChannel &operator=(const ShmChannel &) = delete;
+
+        int memfd() const { return memfd_; }
+        int event_fd(Direction direction) const { return event_fds_[direction]; }
+
+        // Appends head and body as one unit, waiting up to timeout_ms for free space.
+        bool Write(Direction direction, const void *head, std::size_t head_len,
+                   const void *body, std::size_t body_len, int timeout_ms);
+
+        // Appends as many of the len bytes as fit without waiting. If some are left, the consumer
+        // signals the other direction's eventfd once it frees space. Returns false if the peer
+        // corrupted the ring.
+        bool WriteSome(Direction direction, const void *data, std::size_t len, std::size_t *written);
+
+        // Moves every readable byte to out. Returns false if the peer corrupted the ring.
+        bool Drain(Direction direction, std::string &out);
+
+        // Copies up to len readable bytes to out. Returns false if the peer corrupted the ring.
+        bool Read(Direction direction, char *out, std::size_t len, std::size_t *copied);
+
+        // Spins briefly, then sleeps on the eventfd until the ring has data or timeout_ms passed.
+        bool WaitReadable(Direction direction, int timeout_ms);
+
+        // Resets the eventfd counter after a wakeup.
+        void ClearSignal(Direction direction);
+
+    private:
+        struct Layout;
+        struct Ring;
+
+        ShmChannel(int memfd, int request_event_fd, int response_event_fd, void *base, std::size_t size,
+                   std::size_t capacity);
+        Ring RingFor(Direction direction) const;
+        void WakeStalledProducer(Direction direction);
+
+        int memfd_;
+        int event_fds_[2];
+        void *base_;
+        std::size_t size_;
+        std::size_t capacity_; // Bytes per ring, never reread from the mapping the peer can write
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_SHM_CHANNEL_HPP_
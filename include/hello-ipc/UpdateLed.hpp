@@ -2,8 +2,12 @@
 #define HELLO_IPC_UPDATE_LED_HPP_
 
 #include "Service.hpp"
+#include "led_service.pb.h"
 
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <vector>
 
 namespace hello_ipc {
 
@@ -24,13 +28,20 @@ class UpdateLed : public Service {
         UpdateLed(const std::string &socket_path, int argc, char** argv, bool connect = true);
         void Run();
 
+        // Sets the LED to desired if it is expected, in one round trip. Returns nullopt if the
+        // exchange with the server failed; the response tells whether the LED was swapped.
+        std::optional<hello_ipc::CompareAndSetResponse> CompareAndSet(uint32_t led_id, hello_ipc::LedState expected,
+                                                                     hello_ipc::LedState desired);
+
     protected:
         void HandleArguments();
         void HandleUserInput(std::istream &input_stream);
         void SendUpdate(const std::string &led_name, const std::string &led_state);
+        void SendUpdates(const std::vector<std::string> &led_names, const std::string &led_state);
 
         int argc_;
         char** argv_;
+        uint64_t next_request_id_;
 };
 
 } // namespace hello_ipc
@@ -0,0 +1,71 @@
+#ifndef HELLO_IPC_WORKER_POOL_HPP_
+#define HELLO_IPC_WORKER_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hello_ipc {
+
+/**
+ * @file WorkerPool.hpp
+ * @brief Fixed-size pool of worker threads fed by the server event loop.
+ *
+ * Every worker owns its own task queues. Tasks are routed to a worker by a key
+ * (the client socket), so all messages of one connection are handled in order
+ * by the same thread while different connections run in parallel.
+ *
+ * A worker keeps one queue per key and serves the keys with queued tasks round-robin,
+ * one task per turn, so a key that floods its worker only delays its own tasks: every
+ * other key sharing the worker waits for at most one task of each active key.
+ */
+class WorkerPool {
+    public:
+        /**
+         * @brief Starts the worker threads.
+         * @param num_threads Number of workers; 0 means one per available core.
+         */
+        explicit WorkerPool(std::size_t num_threads = 0);
+
+        /**
+         * @brief Drains the pending tasks and joins the worker threads.
+         */
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        /**
+         * @brief Queues a task on the worker selected by key.
+         * @param key Routing key, tasks with the same key run in submission order.
+         * @param task The work to run.
+         */
+        void Submit(std::size_t key, std::function<void()> task);
+
+        std::size_t size() const { return workers_.size(); }
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::condition_variable cv;
+            // Kept when they run empty, so a busy key does not reallocate its queue
+            std::unordered_map<std::size_t, std::deque<std::function<void()>>> queues;
+            std::deque<std::size_t> ready; // Keys with queued tasks, in serving order
+            bool stopping = false;
+            std::thread thread;
+        };
+
+        static void WorkerLoop(Worker &worker);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace hello_ipc
+
+#endif // HELLO_IPC_WORKER_POOL_HPP_
@@ -0,0 +1,58 @@
+#include "CompactMessage.hpp"
+
+#include <cstring>
+
+#include <arpa/inet.h>
+
+namespace hello_ipc {
+
+/**
+ * @brief Encodes a message in the compact wire format.
+ *
+ * @param message The message to encode.
+ * @param out Receives kCompactMessageSize bytes.
+ */
+void EncodeCompactMessage(const CompactMessage &message, char *out) {
+    out[0] = static_cast<char>(message.opcode);
+    out[1] = message.on ? 1 : 0;
+    out[2] = static_cast<char>(message.error);
+    out[3] = 0;
+
+    uint32_t led_id = htonl(message.led_id);
+    uint32_t id_high = htonl(static_cast<uint32_t>(message.request_id >> 32));
+    uint32_t id_low = htonl(static_cast<uint32_t>(message.request_id));
+    memcpy(out + 4, &led_id, sizeof(led_id));
+    memcpy(out + 8, &id_high, sizeof(id_high));
+    memcpy(out + 12, &id_low, sizeof(id_low));
+}
+
+/**
+ * @brief Decodes a message in the compact wire format.
+ *
+ * @param data The frame body.
+ * @param message Receives the decoded fields.
+ * @return false if data has the wrong size or an unknown opcode.
+ */
+bool DecodeCompactMessage(std::string_view data, CompactMessage *message) {
+    if (data.size() != kCompactMessageSize) {
+        return false;
+    }
+
+    uint8_t opcode = static_cast<uint8_t>(data[0]);
+    if (opcode < static_cast<uint8_t>(CompactOpcode::kUpdate) || opcode > static_cast<uint8_t>(CompactOpcode::kError)) {
+        return false;
+    }
+    message->opcode = static_cast<CompactOpcode>(opcode);
+    message->on = data[1] != 0;
+    message->error = static_cast<CompactError>(data[2]);
+
+    uint32_t led_id, id_high, id_low;
+    memcpy(&led_id, data.data() + 4, sizeof(led_id));
+    memcpy(&id_high, data.data() + 8, sizeof(id_high));
+    memcpy(&id_low, data.data() + 12, sizeof(id_low));
+    message->led_id = ntohl(led_id);
+    message->request_id = (static_cast<uint64_t>(ntohl(id_high)) << 32) | ntohl(id_low);
+    return true;
+}
+
+} // namespace hello_ipc
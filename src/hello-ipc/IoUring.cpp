@@ -0,0 +1,412 @@
+#include "IoUring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace hello_ipc {
+
+namespace {
+
+template <typename T>
+T *Offset(void *base, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+unsigned LoadAcquire(const unsigned *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+void StoreRelease(unsigned *p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+} // namespace
+
+/**
+ * @brief Creates the ring and maps the submission and completion queues.
+ *
+ * @param entries Requested number of submission queue entries.
+ * @throws std::runtime_error if the kernel does not support io_uring.
+ */
+IoUring::IoUring(unsigned entries)
+    : ring_fd_(-1), sq_ring_ptr_(MAP_FAILED), sq_ring_size_(0), cq_ring_ptr_(MAP_FAILED),
+      cq_ring_size_(0), sqes_ptr_(MAP_FAILED), sqes_size_(0),
+      buf_ring_(MAP_FAILED), buf_ring_size_(0), buf_count_(0), buf_size_(0) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) {
+        throw std::runtime_error("io_uring_setup failed: " + std::string(strerror(errno)));
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ptr_ != MAP_FAILED) {
+        cq_ring_ptr_ = single_mmap ? sq_ring_ptr_
+                                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (cq_ring_ptr_ != MAP_FAILED) {
+        sqes_ptr_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring_fd_, IORING_OFF_SQES);
+    }
+    if (sq_ring_ptr_ == MAP_FAILED || cq_ring_ptr_ == MAP_FAILED || sqes_ptr_ == MAP_FAILED) {
+        std::string error = strerror(errno);
+        Release();
+        throw std::runtime_error("Failed to map io_uring queues: " + error);
+    }
+
+    sq_head_ = Offset<unsigned>(sq_ring_ptr_, params.sq_off.head);
+    sq_tail_ = Offset<unsigned>(sq_ring_ptr_, params.sq_off.tail);
+    sq_mask_ = Offset<unsigned>(sq_ring_ptr_, params.sq_off.ring_mask);
+    sq_array_ = Offset<unsigned>(sq_ring_ptr_, params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+    cq_head_ = Offset<unsigned>(cq_ring_ptr_, params.cq_off.head);
+    cq_tail_ = Offset<unsigned>(cq_ring_ptr_, params.cq_off.tail);
+    cq_mask_ = Offset<unsigned>(cq_ring_ptr_, params.cq_off.ring_mask);
+    cqes_ = Offset<void>(cq_ring_ptr_, params.cq_off.cqes);
+
+    // Submission slots map one to one onto the SQE array
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array_[i] = i;
+    }
+}
+
+/**
+ * @brief Unmaps the queues and closes the ring, which cancels outstanding requests.
+ */
+IoUring::~IoUring() {
+    Release();
+}
+
+void IoUring::Release() {
+    if (buf_ring_ != MAP_FAILED) munmap(buf_ring_, buf_ring_size_);
+    if (sqes_ptr_ != MAP_FAILED) munmap(sqes_ptr_, sqes_size_);
+    if (cq_ring_ptr_ != MAP_FAILED && cq_ring_ptr_ != sq_ring_ptr_) munmap(cq_ring_ptr_, cq_ring_size_);
+    if (sq_ring_ptr_ != MAP_FAILED) munmap(sq_ring_ptr_, sq_ring_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+    buf_ring_ = sqes_ptr_ = cq_ring_ptr_ = sq_ring_ptr_ = MAP_FAILED;
+    ring_fd_ = -1;
+}
+
+/**
+ * @brief Registers a provided buffer ring that multishot receives pick buffers from.
+ *
+ * @param group_id Buffer group id referenced by QueueMultishotRecv().
+ * @param count Number of buffers, must be a power of two.
+ * @param size Size of every buffer in bytes.
+ * @return true on success, false if the kernel rejected the registration.
+ */
+bool IoUring::SetupBufferRing(uint16_t group_id, uint16_t count, uint32_t size) {
+    buf_ring_size_ = count * sizeof(struct io_uring_buf);
+    buf_ring_ = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring_ == MAP_FAILED) {
+        return false;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = count;
+    reg.bgid = group_id;
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = MAP_FAILED;
+        return false;
+    }
+
+    buf_count_ = count;
+    buf_size_ = size;
+    buffers_.assign(static_cast<std::size_t>(count) * size, 0);
+    for (uint16_t bid = 0; bid < count; ++bid) {
+        RecycleBuffer(bid);
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that the kernel runs multishot receives into a provided buffer ring.
+ *
+ * Provided buffer rings and multishot accept came with Linux 5.19, multishot recv
+ * only with 6.0, and the kernel rejects unknown request flags only once a request
+ * runs. So a multishot recv is run on a socket pair, which also
+ * covers the buffer ring. Call before queueing anything else; every completion of
+ * the probe is reaped here.
+ *
+ * @param group_id Buffer group registered with SetupBufferRing().
+ * @return true if a multishot recv delivered data into a provided buffer.
+ */
+bool IoUring::ProbeMultishotRecv(uint16_t group_id) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        return false;
+    }
+    const char byte = 0;
+    bool queued = QueueMultishotRecv(fds[0], group_id, 0) && write(fds[1], &byte, 1) == 1;
+    close(fds[1]); // Ends a running multishot recv with end-of-file
+
+    bool supported = false;
+    bool more = queued;
+    while (more) {
+        if (Submit(1) < 0) {
+            break; // The pair is closed below, the ring is not used after a failed probe
+        }
+        Completion cqe;
+        while (more && ReapCompletions(&cqe, 1) == 1) {
+            if (HasBuffer(cqe.flags)) {
+                RecycleBuffer(BufferId(cqe.flags));
+            }
+            if (cqe.res > 0 && HasMore(cqe.flags)) {
+                supported = true;
+            }
+            more = HasMore(cqe.flags);
+        }
+    }
+    close(fds[0]);
+    return supported && !more;
+}
+
+const char *IoUring::BufferData(uint16_t buffer_id) const {
+    return buffers_.data() + static_cast<std::size_t>(buffer_id) * buf_size_;
+}
+
+/**
+ * @brief Hands a consumed buffer back to the kernel.
+ *
+ * @param buffer_id Id reported in the completion flags.
+ */
+void IoUring::RecycleBuffer(uint16_t buffer_id) {
+    auto *bufs = static_cast<struct io_uring_buf *>(buf_ring_);
+    // The ring tail overlays the reserved field of the first entry
+    unsigned short *tail = &bufs[0].resv;
+    unsigned short index = *tail;
+
+    struct io_uring_buf &buf = bufs[index & (buf_count_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(BufferData(buffer_id));
+    buf.len = buf_size_;
+    buf.bid = buffer_id;
+    __atomic_store_n(tail, static_cast<unsigned short>(index + 1), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Submits queued entries until at least count submission entries are free.
+ *
+ * Must be called with sq_mutex_ held.
+ *
+ * @return false if the kernel takes no more entries, in which case nothing may be queued.
+ */
+bool IoUring::MakeRoom(unsigned count) {
+    while (sq_local_tail_ - LoadAcquire(sq_head_) + count > sq_entries_) {
+        Publish();
+        if (Enter(sq_local_tail_ - LoadAcquire(sq_head_), 0) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the next free submission entry, flushing the queue if it is full.
+ *
+ * The entry only becomes visible to the kernel once Publish() is called.
+ * Must be called with sq_mutex_ held.
+ *
+ * @return nullptr if the queue is full and cannot be flushed.
+ */
+void *IoUring::NextSqe() {
+    if (!MakeRoom(1)) {
+        return nullptr;
+    }
+    auto *sqe = static_cast<struct io_uring_sqe *>(sqes_ptr_) + (sq_local_tail_ & *sq_mask_);
+    memset(sqe, 0, sizeof(*sqe));
+    ++sq_local_tail_;
+    return sqe;
+}
+
+/**
+ * @brief Makes every prepared entry visible to the kernel.
+ *
+ * Must be called with sq_mutex_ held.
+ */
+void IoUring::Publish() {
+    StoreRelease(sq_tail_, sq_local_tail_);
+}
+
+bool IoUring::QueueMultishotAccept(int fd, uint64_t user_data) {
+    std::lock_guard<std::mutex> lock(sq_mutex_);
+    auto *sqe = static_cast<struct io_uring_sqe *>(NextSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = user_data;
+    Publish();
+    return true;
+}
+
+bool IoUring::QueueMultishotRecv(int fd, uint16_t group_id, uint64_t user_data) {
+    std::lock_guard<std::mutex> lock(sq_mutex_);
+    auto *sqe = static_cast<struct io_uring_sqe *>(NextSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = group_id;
+    sqe->user_data = user_data;
+    Publish();
+    return true;
+}
+
+bool IoUring::QueueRead(int fd, void *buf, std::size_t len, uint64_t user_data) {
+    std::lock_guard<std::mutex> lock(sq_mutex_);
+    auto *sqe = static_cast<struct io_uring_sqe *>(NextSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->user_data = user_data;
+    Publish();
+    return true;
+}
+
+/**
+ * @brief Queues two sends that the kernel runs back to back.
+ *
+ * The body only starts once the head was fully sent and is cancelled if the head fails.
+ *
+ * @return false if the queue is full and cannot be flushed; nothing was queued then.
+ */
+bool IoUring::QueueLinkedSend(int fd, const void *head, std::size_t head_len, uint64_t head_user_data,
+                              const void *body, std::size_t body_len, uint64_t body_user_data) {
+    std::lock_guard<std::mutex> lock(sq_mutex_);
+    // Both entries must be published together, otherwise a submission could split the link
+    if (!MakeRoom(2)) {
+        return false;
+    }
+
+    auto *first = static_cast<struct io_uring_sqe *>(NextSqe());
+    first->opcode = IORING_OP_SEND;
+    first->fd = fd;
+    first->addr = reinterpret_cast<uint64_t>(head);
+    first->len = static_cast<uint32_t>(head_len);
+    first->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    first->flags = IOSQE_IO_LINK;
+    first->user_data = head_user_data;
+
+    auto *second = static_cast<struct io_uring_sqe *>(NextSqe());
+    second->opcode = IORING_OP_SEND;
+    second->fd = fd;
+    second->addr = reinterpret_cast<uint64_t>(body);
+    second->len = static_cast<uint32_t>(body_len);
+    second->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    second->user_data = body_user_data;
+    Publish();
+    return true;
+}
+
+bool IoUring::QueueCancelAll(uint64_t user_data) {
+    std::lock_guard<std::mutex> lock(sq_mutex_);
+    auto *sqe = static_cast<struct io_uring_sqe *>(NextSqe());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = user_data;
+    Publish();
+    return true;
+}
+
+/**
+ * @brief Sends every queued request, then waits for completions if asked to.
+ *
+ * The entries are submitted with sq_mutex_ held, so no other thread's submission
+ * can take part of a linked pair. The wait runs without the lock, in a call of its
+ * own that is skipped while completions are ready.
+ *
+ * @param wait_nr Minimum number of completions to wait for.
+ * @return The number of submitted requests, or -errno.
+ */
+int IoUring::Submit(unsigned wait_nr) {
+    int submitted = 0;
+    {
+        std::lock_guard<std::mutex> lock(sq_mutex_);
+        unsigned pending = sq_local_tail_ - LoadAcquire(sq_head_);
+        if (pending > 0) {
+            submitted = Enter(pending, 0);
+        }
+    }
+    if (submitted < 0 || wait_nr == 0 || LoadAcquire(cq_tail_) != *cq_head_) {
+        return submitted;
+    }
+    int ret = Enter(0, wait_nr);
+    return ret < 0 ? ret : submitted;
+}
+
+int IoUring::Enter(unsigned to_submit, unsigned wait_nr) {
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        long ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags, nullptr, 0);
+        if (ret >= 0) {
+            return static_cast<int>(ret);
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+/**
+ * @brief Copies available completions and releases their slots to the kernel.
+ *
+ * @param out Destination array.
+ * @param max Capacity of out.
+ * @return The number of completions copied.
+ */
+unsigned IoUring::ReapCompletions(Completion *out, unsigned max) {
+    unsigned head = *cq_head_;
+    unsigned tail = LoadAcquire(cq_tail_);
+    unsigned count = 0;
+
+    for (; head != tail && count < max; ++head, ++count) {
+        const auto &cqe = static_cast<const struct io_uring_cqe *>(cqes_)[head & *cq_mask_];
+        out[count] = {cqe.user_data, cqe.res, cqe.flags};
+    }
+    StoreRelease(cq_head_, head);
+    return count;
+}
+
+bool IoUring::HasMore(uint32_t flags) { return (flags & IORING_CQE_F_MORE) != 0; }
+
+bool IoUring::HasBuffer(uint32_t flags) { return (flags & IORING_CQE_F_BUFFER) != 0; }
+
+uint16_t IoUring::BufferId(uint32_t flags) {
+    return static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
+} // namespace hello_ipc
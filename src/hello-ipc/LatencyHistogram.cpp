@@ -0,0 +1,101 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace hello_ipc {
+
+namespace {
+
+const unsigned kSubBucketBits = 7;
+const uint64_t kSubBucketCount = 1ULL << kSubBucketBits;
+// Values below kSubBucketCount get exact buckets, every power of two above gets kSubBucketCount buckets
+const std::size_t kBucketCount = kSubBucketCount * (64 - kSubBucketBits + 1);
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : buckets_(kBucketCount, 0), count_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0), sum_(0) {}
+
+/**
+ * @brief Counts one value.
+ */
+void LatencyHistogram::Record(uint64_t value) {
+    ++buckets_[BucketIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+}
+
+/**
+ * @brief Adds every value counted by other to this histogram.
+ */
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+/**
+ * @brief Forgets every recorded value.
+ */
+void LatencyHistogram::Reset() {
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+    sum_ = 0;
+}
+
+/**
+ * @brief Returns the value below which the given percentage of the recorded values fall.
+ *
+ * @param percentile Percentage between 0 and 100.
+ * @return The upper bound of the bucket holding that value, capped at the largest
+ *         recorded value; 0 if nothing was recorded.
+ */
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count_)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(std::max(BucketUpperBound(i), min_), max_);
+        }
+    }
+    return max_;
+}
+
+std::size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<std::size_t>(value);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value)); // >= kSubBucketBits
+    unsigned shift = exponent - kSubBucketBits;
+    uint64_t sub_bucket = (value >> shift) - kSubBucketCount;
+    return static_cast<std::size_t>(kSubBucketCount * (shift + 1) + sub_bucket);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(std::size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / kSubBucketCount) - 1;
+    uint64_t sub_bucket = index % kSubBucketCount;
+    uint64_t lower = (kSubBucketCount + sub_bucket) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+} // namespace hello_ipc
@@ -0,0 +1,153 @@
+#include "LedFileCache.hpp"
+
+#include <cerrno>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hello_ipc {
+
+/**
+ * @brief Constructs an empty cache.
+ *
+ * @param capacity Maximum number of open descriptors, at least one.
+ * @param root Directory holding the led_<id> directories.
+ * @param stale_check_interval How long a cached descriptor is used before it is checked for an unlinked file.
+ */
+LedFileCache::LedFileCache(std::size_t capacity, const std::string &root,
+                           std::chrono::milliseconds stale_check_interval)
+    : capacity_(capacity > 0 ? capacity : 1), root_(root), stale_check_interval_(stale_check_interval) {}
+
+/**
+ * @brief Closes every cached descriptor.
+ */
+LedFileCache::~LedFileCache() {
+    for (const Entry &entry : lru_) {
+        close(entry.fd);
+    }
+}
+
+/**
+ * @brief Writes a LED value with a single pwrite.
+ *
+ * A failed write drops the descriptor and is retried once on a reopened file.
+ *
+ * @param led_id The id of the LED to write.
+ * @param value The character to write, '1' or '0'.
+ * @return True if the write was successful, false otherwise.
+ */
+bool LedFileCache::Write(uint32_t led_id, char value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char data[2] = {value, '\n'};
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int fd = Acquire(led_id, true);
+        if (fd < 0) {
+            return false;
+        }
+        if (pwrite(fd, data, sizeof(data), 0) == static_cast<ssize_t>(sizeof(data))) {
+            return true;
+        }
+        Evict(entries_[led_id]);
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a LED value with a single pread.
+ *
+ * A failed read drops the descriptor and is retried once on a reopened file.
+ *
+ * @param led_id The id of the LED to read.
+ * @param value Receives the first byte of the file.
+ * @return false if the file does not exist or is empty.
+ */
+bool LedFileCache::Read(uint32_t led_id, char *value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int fd = Acquire(led_id, false);
+        if (fd < 0) {
+            return false;
+        }
+        if (pread(fd, value, 1, 0) == 1) {
+            return true;
+        }
+        Evict(entries_[led_id]);
+    }
+    return false;
+}
+
+std::size_t LedFileCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+/**
+ * @brief Returns the cached descriptor of a LED, opening it on a miss.
+ *
+ * A hit costs no syscall: the clock is read through the vDSO, and only once per
+ * stale_check_interval_ an fstat checks whether the file still has links. A
+ * descriptor whose file is gone is stale and gets reopened.
+ * The caller must hold mutex_.
+ *
+ * @param led_id The id of the LED.
+ * @param create Whether to create the directory and file if they do not exist.
+ * @return The descriptor, or -1 if the file cannot be opened.
+ */
+int LedFileCache::Acquire(uint32_t led_id, bool create) {
+    auto now = std::chrono::steady_clock::now();
+    auto found = entries_.find(led_id);
+    if (found != entries_.end()) {
+        Entry &entry = *found->second;
+        bool linked = true;
+        if (now - entry.checked >= stale_check_interval_) {
+            struct stat st;
+            linked = fstat(entry.fd, &st) == 0 && st.st_nlink > 0;
+            entry.checked = now;
+        }
+        if (linked) {
+            lru_.splice(lru_.begin(), lru_, found->second);
+            return entry.fd;
+        }
+        Evict(found->second);
+    }
+
+    std::string dir = LedDirectory(led_id);
+    std::string path = dir + "/brightness";
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0);
+    int fd = open(path.c_str(), flags, 0644);
+    if (fd < 0 && errno == ENOENT && create) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            return -1;
+        }
+        fd = open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (entries_.size() >= capacity_) {
+        Evict(std::prev(lru_.end()));
+    }
+    lru_.push_front({led_id, fd, now});
+    entries_[led_id] = lru_.begin();
+    return fd;
+}
+
+/**
+ * @brief Closes a cached descriptor and forgets it. The caller must hold mutex_.
+ */
+void LedFileCache::Evict(std::list<Entry>::iterator it) {
+    close(it->fd);
+    entries_.erase(it->led_id);
+    lru_.erase(it);
+}
+
+std::string LedFileCache::LedDirectory(uint32_t led_id) const {
+    return root_ + "/led_" + std::to_string(led_id);
+}
+
+} // namespace hello_ipc
@@ -1,16 +1,239 @@
 #include "LedManager.hpp"
 #include "led_service.pb.h"
 
-#include <filesystem>
-#include <fstream>
+#include <charconv>
 #include <iostream>
+#include <unordered_set>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
 
 namespace hello_ipc {
 
+namespace {
+
+// How long the flusher waits after the first pending update so bursts share one write per LED.
+const std::chrono::milliseconds kFlushDelay(5);
+
+// A journal is folded into a new snapshot after this long, or once it holds kCheckpointEntries.
+const std::chrono::seconds kCheckpointInterval(60);
+const std::size_t kCheckpointEntries = 1 << 20;
+
+// Notifications wait in the subscriber's backlog while the server holds this much unsent data for
+// it; the notifier checks again after kNotifyRetryDelay. A subscriber with more than
+// kMaxPendingNotifications LEDs in its backlog is dropped.
+const std::size_t kMaxUnsentNotificationBytes = 64 * 1024;
+const std::chrono::milliseconds kNotifyRetryDelay(10);
+const std::size_t kMaxPendingNotifications = 64 * 1024;
+
+// Size of the arena block every worker thread keeps for its request and response messages.
+const std::size_t kArenaBlockSize = 16 * 1024;
+
+/**
+ * @brief Per-thread memory reused by every request a worker handles.
+ *
+ * The request and response messages are created on an arena whose first block is
+ * owned here, so resetting it between requests returns the memory without freeing
+ * it. Only requests that outgrow the block (large batches) touch the heap.
+ */
+struct RequestScratch {
+    RequestScratch() : arena(ArenaOptions(block, sizeof(block))) {}
+
+    static google::protobuf::ArenaOptions ArenaOptions(char *initial_block, std::size_t size) {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = initial_block;
+        options.initial_block_size = size;
+        return options;
+    }
+
+    alignas(8) char block[kArenaBlockSize];
+    google::protobuf::Arena arena;
+    std::string response_buffer;
+};
+
+RequestScratch &ThreadScratch() {
+    static thread_local RequestScratch scratch;
+    return scratch;
+}
+
+/**
+ * @brief Parses a LED number into its numeric id.
+ *
+ * @param led_num The LED number as sent by clients, decimal digits only.
+ * @param led_id Receives the parsed id.
+ * @return false if led_num is not a valid decimal number.
+ */
+bool ParseLedId(const std::string &led_num, uint32_t *led_id) {
+    const char *first = led_num.data();
+    const char *last = first + led_num.size();
+    auto result = std::from_chars(first, last, *led_id);
+    return !led_num.empty() && result.ec == std::errc() && result.ptr == last;
+}
+
+/**
+ * @brief Gets the LED a single LED request refers to, preferring the numeric id.
+ *
+ * @param req A LedUpdateRequest or LedQueryRequest.
+ * @param led_id Receives the id.
+ * @return false if the request has no led_id and an invalid led_num.
+ */
+template <typename LedRequest>
+bool RequestedLedId(const LedRequest &req, uint32_t *led_id) {
+    if (req.has_led_id()) {
+        *led_id = req.led_id();
+        return true;
+    }
+    return ParseLedId(req.led_num(), led_id);
+}
+
+/**
+ * @brief Identifies the LED in a response with the same fields the request used.
+ *
+ * Clients that send led_id get no string back; older clients get their led_num.
+ */
+template <typename LedRequest>
+void EchoLedId(const LedRequest &req, LedStateResponse *res) {
+    if (req.has_led_id()) {
+        res->set_led_id(req.led_id());
+    }
+    if (!req.led_num().empty()) {
+        res->set_led_num(req.led_num());
+    }
+}
+
+/**
+ * @brief Fills a response with the looked up state, or the reason there is none.
+ */
+template <typename LedRequest>
+void SetQueryResult(const LedRequest &req, std::optional<hello_ipc::LedState> led_state, LedStateResponse *res) {
+    if (led_state) {
+        res->set_state(*led_state);
+    } else if (!req.has_led_id() && req.led_num().empty()) {
+        res->set_error_message("error: LED number cannot be empty");
+    } else {
+        res->set_error_message("error: LED not found");
+    }
+}
+
+/**
+ * @brief Finds the lane of a serialized Request without parsing it.
+ *
+ * Only the top-level tags are decoded: the field number of the request type and an
+ * explicit priority decide the lane, every nested message is skipped unread.
+ *
+ * @param message The serialized Request.
+ * @return The lane; bulk for a message that cannot be decoded, which the handler rejects.
+ */
+Service::Lane RequestLane(std::string_view message) {
+    // Wire types of the protobuf encoding, the low three bits of a tag
+    enum WireType : uint32_t { kVarint = 0, kFixed64 = 1, kLengthDelimited = 2, kFixed32 = 5 };
+
+    google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t *>(message.data()),
+                                                 static_cast<int>(message.size()));
+    bool read_only = false;
+    uint32_t priority = hello_ipc::PRIORITY_AUTO;
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        uint32_t field = tag >> 3;
+        uint32_t wire_type = tag & 7;
+        if (field == hello_ipc::Request::kQueryRequestFieldNumber ||
+            field == hello_ipc::Request::kBatchQueryRequestFieldNumber ||
+            field == hello_ipc::Request::kStatsRequestFieldNumber) {
+            read_only = true;
+        }
+
+        bool skipped;
+        uint64_t varint;
+        uint32_t length;
+        switch (wire_type) {
+            case kVarint:
+                skipped = input.ReadVarint64(&varint);
+                if (skipped && field == hello_ipc::Request::kPriorityFieldNumber) {
+                    priority = static_cast<uint32_t>(varint);
+                }
+                break;
+            case kFixed64:
+                skipped = input.Skip(8);
+                break;
+            case kLengthDelimited:
+                skipped = input.ReadVarint32(&length) && input.Skip(static_cast<int>(length));
+                break;
+            case kFixed32:
+                skipped = input.Skip(4);
+                break;
+            default:
+                skipped = false; // Groups are not used by led_service.proto
+                break;
+        }
+        if (!skipped || (field == hello_ipc::Request::kPriorityFieldNumber && wire_type != kVarint)) {
+            return Service::Lane::kBulk;
+        }
+    }
+
+    if (priority == hello_ipc::PRIORITY_INTERACTIVE) {
+        return Service::Lane::kInteractive;
+    }
+    if (priority == hello_ipc::PRIORITY_BULK) {
+        return Service::Lane::kBulk;
+    }
+    return read_only ? Service::Lane::kInteractive : Service::Lane::kBulk;
+}
+
+} // namespace
+
 /**
- * @brief Constructs a LedManager service.
+ * @brief LED filter and destination of one subscribed client.
  */
-LedManager::LedManager() : Service("LedManager", true) {}
+struct LedManager::Subscription {
+    int client_socket;
+    uint64_t request_id; // Echoed in every notification
+    std::shared_ptr<const void> connection; // Keeps the descriptor from being reused
+    std::unordered_set<uint32_t> leds;
+    bool has_range = false;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    std::unordered_map<uint32_t, hello_ipc::LedState> pending; // Latest unsent state per LED, notifier only
+
+    bool Matches(uint32_t led_id) const {
+        if (leds.empty() && !has_range) {
+            return true;
+        }
+        return leds.count(led_id) > 0 || (has_range && led_id >= first && led_id <= last);
+    }
+};
+
+/**
+ * @brief Constructs a LedManager service and starts the flusher thread.
+ *
+ * The server logs asynchronously so logging stays off the request path.
+ */
+LedManager::LedManager() : Service("LedManager", true, Logger::Mode::kAsync) {
+    flusher_ = std::thread([this]() { FlushLoop(); });
+    notifier_ = std::thread([this]() { NotifyLoop(); });
+}
+
+/**
+ * @brief Stops the notifier, writes the pending state changes and stops the flusher thread.
+ */
+LedManager::~LedManager() {
+    {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        notifier_stopping_ = true;
+    }
+    notify_cv_.notify_one();
+    if (notifier_.joinable()) {
+        notifier_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_one();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+}
 
 /**
  * @brief Runs the LedManager server, listening for incoming connections.
@@ -18,48 +241,235 @@ LedManager::LedManager() : Service("LedManager", true) {}
  * @param socket_path Path to the socket file for communication.
  */
 void LedManager::Run(const std::string &socket_path) {
-    RunServer(socket_path, [this](int client_socket, const std::string &msg) {
+    RunServer(socket_path, [this](int client_socket, std::string_view msg) {
         this->HandleMessage(client_socket, msg);
     });
+    Flush();
+    Checkpoint();
+
+    // Release the pinned sockets of the remaining subscribers
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    subscriptions_.clear();
+    subscription_count_.store(0, std::memory_order_relaxed);
 }
 
 /** 
  * @brief Handles incoming messages from clients.
  * 
  * Parses the message and dispatches it to the appropriate handler based on the request type.
+ * The request and response live on the worker thread's arena, which is reset on every
+ * call, so the steady-state path does not allocate.
  * 
  * @param client_socket The socket descriptor of the connected client.
  * @param message The received message from the client.
  */
-void LedManager::HandleMessage(int client_socket, const std::string &message) {
-    hello_ipc::Request req;
+void LedManager::HandleMessage(int client_socket, std::string_view message) {
+    if (ClientUsesCompactFormat()) {
+        HandleCompactMessage(client_socket, message);
+        return;
+    }
+
+    RequestScratch &scratch = ThreadScratch();
+    scratch.arena.Reset();
+    auto &req = *google::protobuf::Arena::CreateMessage<hello_ipc::Request>(&scratch.arena);
+    auto &res = *google::protobuf::Arena::CreateMessage<hello_ipc::Response>(&scratch.arena);
 
-    if (!req.ParseFromString(message)) {
+    uint64_t stage_start = Metrics::Now();
+    if (!req.ParseFromArray(message.data(), static_cast<int>(message.size()))) {
+        metrics().Add(Metrics::kParseFailures);
         logger().Log("Failed to parse request from client.");
         return;
     }
+    metrics().RecordSince(Metrics::kParse, stage_start);
 
-    hello_ipc::Response res;
+    res.set_request_id(req.request_id());
 
+    stage_start = Metrics::Now();
+    std::shared_ptr<Subscription> subscription;
     switch (req.request_type_case()) {
         case hello_ipc::Request::kUpdateRequest:
+            metrics().Add(Metrics::kUpdateRequests);
             HandleUpdateRequest(req.update_request(), res.mutable_state_response());
             break;
         case hello_ipc::Request::kQueryRequest:
+            metrics().Add(Metrics::kQueryRequests);
             HandleQueryRequest(req.query_request(), res.mutable_state_response());
             break;
+        case hello_ipc::Request::kBatchUpdateRequest:
+            metrics().Add(Metrics::kBatchUpdateRequests);
+            HandleBatchUpdateRequest(req.batch_update_request(), res.mutable_batch_state_response());
+            break;
+        case hello_ipc::Request::kBatchQueryRequest:
+            metrics().Add(Metrics::kBatchQueryRequests);
+            HandleBatchQueryRequest(req.batch_query_request(), res.mutable_batch_state_response());
+            break;
+        case hello_ipc::Request::kStatsRequest:
+            metrics().Add(Metrics::kStatsRequests);
+            HandleStatsRequest(req.stats_request(), res.mutable_stats_response());
+            break;
+        case hello_ipc::Request::kSubscribeRequest:
+            metrics().Add(Metrics::kSubscribeRequests);
+            subscription = HandleSubscribeRequest(client_socket, req.request_id(), req.subscribe_request(),
+                                                  res.mutable_subscribe_response());
+            break;
+        case hello_ipc::Request::kCompareAndSetRequest:
+            metrics().Add(Metrics::kCompareAndSetRequests);
+            HandleCompareAndSetRequest(req.compare_and_set_request(), res.mutable_compare_and_set_response());
+            break;
         case hello_ipc::Request::REQUEST_TYPE_NOT_SET:
         default:
             logger().Log("Received request with no type set");
             return;
     }
+    metrics().RecordSince(Metrics::kHandle, stage_start);
 
+    // Serialize into the thread's buffer, whose capacity survives between requests
+    stage_start = Metrics::Now();
+    std::string &response_str = scratch.response_buffer;
+    response_str.resize(res.ByteSizeLong());
+    res.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t *>(response_str.data()));
+    metrics().RecordSince(Metrics::kSerialize, stage_start);
+    SendResponse(client_socket, response_str);
+    if (subscription) {
+        // The notifier may push to the client as soon as it is registered
+        FlushHeldResponses();
+        AddSubscription(std::move(subscription));
+    }
+}
+
+/** 
+ * @brief Handles a message from a client that negotiated the compact encoding.
+ * 
+ * @param client_socket The socket descriptor of the connected client.
+ * @param message The received CompactMessage.
+ */
+void LedManager::HandleCompactMessage(int client_socket, std::string_view message) {
+    uint64_t stage_start = Metrics::Now();
+    CompactMessage req;
+    if (!DecodeCompactMessage(message, &req)) {
+        metrics().Add(Metrics::kParseFailures);
+        logger().Log("Failed to parse compact request from client.");
+        return;
+    }
+    metrics().RecordSince(Metrics::kParse, stage_start);
+
+    stage_start = Metrics::Now();
+    CompactMessage res;
+    HandleCompactRequest(req, &res);
+    metrics().RecordSince(Metrics::kHandle, stage_start);
+
+    stage_start = Metrics::Now();
+    std::string &response_str = ThreadScratch().response_buffer;
+    response_str.resize(kCompactMessageSize);
+    EncodeCompactMessage(res, response_str.data());
+    metrics().RecordSince(Metrics::kSerialize, stage_start);
+    SendResponse(client_socket, response_str);
+}
+
+/** 
+ * @brief Sends queries to the interactive lane and updates to the bulk lane.
+ * 
+ * Runs on the event loop thread for every message, so it only peeks at the request:
+ * the opcode of a CompactMessage, the top-level tags of a protobuf Request, whose
+ * priority field overrides the choice by request type.
+ * 
+ * @param message The received message.
+ * @param wire_format The encoding the client negotiated.
+ * @return The lane the message is handled in.
+ */
+Service::Lane LedManager::ClassifyMessage(std::string_view message, WireFormat wire_format) const {
+    if (wire_format == WireFormat::kCompact) {
+        bool query = !message.empty() &&
+                     static_cast<uint8_t>(message[0]) == static_cast<uint8_t>(CompactOpcode::kQuery);
+        return query ? Lane::kInteractive : Lane::kBulk;
+    }
+    return RequestLane(message);
+}
+
+/** 
+ * @brief Answers a message that arrived while the client was at its in-flight limit.
+ * 
+ * The request is not handled, only decoded far enough to echo its request id, so
+ * a flooding client gets a quick OVERLOADED answer and can back off.
+ * 
+ * @param message The received message from the client.
+ * @param wire_format The encoding the client negotiated.
+ * @return The answer, or nullopt if the message cannot be decoded.
+ */
+std::optional<std::string> LedManager::OverloadedResponse(std::string_view message, WireFormat wire_format) const {
     std::string response_str;
-    if (res.SerializeToString(&response_str)) {
-        SendResponse(client_socket, response_str);
-    } else {
-        logger().Log("Failed to serialize response");
+    if (wire_format == WireFormat::kCompact) {
+        CompactMessage req;
+        if (!DecodeCompactMessage(message, &req)) {
+            metrics().Add(Metrics::kParseFailures);
+            return std::nullopt;
+        }
+        CompactMessage res;
+        res.opcode = CompactOpcode::kError;
+        res.error = CompactError::kOverloaded;
+        res.led_id = req.led_id;
+        res.request_id = req.request_id;
+        response_str.resize(kCompactMessageSize);
+        EncodeCompactMessage(res, response_str.data());
+        return response_str;
+    }
+
+    RequestScratch &scratch = ThreadScratch();
+    scratch.arena.Reset();
+    auto &req = *google::protobuf::Arena::CreateMessage<hello_ipc::Request>(&scratch.arena);
+    auto &res = *google::protobuf::Arena::CreateMessage<hello_ipc::Response>(&scratch.arena);
+    if (!req.ParseFromArray(message.data(), static_cast<int>(message.size()))) {
+        metrics().Add(Metrics::kParseFailures);
+        return std::nullopt;
+    }
+    res.set_request_id(req.request_id());
+    auto *state_res = res.mutable_state_response();
+    state_res->set_code(hello_ipc::ResponseCode::OVERLOADED);
+    state_res->set_error_message("Server overloaded");
+    response_str.resize(res.ByteSizeLong());
+    res.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t *>(response_str.data()));
+    return response_str;
+}
+
+/** 
+ * @brief Answers a compact update or query request.
+ * 
+ * Works on the numeric LED id directly, so no LED number string is built or parsed.
+ * 
+ * @param req The decoded request.
+ * @param res Receives the response.
+ */
+void LedManager::HandleCompactRequest(const CompactMessage &req, CompactMessage *res) {
+    res->request_id = req.request_id;
+    res->led_id = req.led_id;
+    res->opcode = CompactOpcode::kState;
+
+    if (req.opcode == CompactOpcode::kUpdate) {
+        metrics().Add(Metrics::kUpdateRequests);
+        hello_ipc::LedState led_state = req.on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF;
+        logger().Log(LogId::kUpdateReceived, req.led_id, req.on ? "on" : "off");
+        if (CommitLedState(req.led_id, led_state)) {
+            logger().Log(LogId::kLedUpdated, req.led_id, req.on ? "on" : "off");
+        }
+        res->on = req.on;
+        return;
+    }
+    if (req.opcode == CompactOpcode::kQuery) {
+        metrics().Add(Metrics::kQueryRequests);
+        logger().Log(LogId::kQueryReceived, req.led_id);
+        std::optional<hello_ipc::LedState> led_state = LookupLedState(req.led_id);
+        if (!led_state) {
+            res->opcode = CompactOpcode::kError;
+            res->error = CompactError::kNotFound;
+        } else {
+            res->on = *led_state == hello_ipc::LedState::ON;
+        }
+        return;
     }
+
+    logger().Log("Received compact message that is not a request");
+    res->opcode = CompactOpcode::kError;
+    res->error = CompactError::kBadRequest;
 }
 
 /** 
@@ -71,15 +481,20 @@ void LedManager::HandleMessage(int client_socket, const std::string &message) {
  * @param res The state response message to populate.
  */
 void LedManager::HandleUpdateRequest(const LedUpdateRequest &req, LedStateResponse *res) {
-    const std::string &led_state_str = (req.state() == hello_ipc::LedState::ON) ? "on" : "off";
+    const char *led_state_str = (req.state() == hello_ipc::LedState::ON) ? "on" : "off";
 
-    logger().Log("Received update for LED: " + req.led_num() + " to state: " + led_state_str);
+    EchoLedId(req, res);
 
-    UpdateLedState(req.led_num(), req.state());
+    uint32_t led_id;
+    if (!RequestedLedId(req, &led_id)) {
+        logger().Log("Invalid LED number: " + req.led_num());
+        res->set_error_message("Failed to update LED state on the system.");
+        return;
+    }
 
-    res->set_led_num(req.led_num());
+    logger().Log(LogId::kUpdateReceived, led_id, led_state_str);
 
-    if (UpdateLedState(req.led_num(), req.state())) {
+    if (UpdateLedState(led_id, req.state())) {
         res->set_state(req.state());
     } else {
         res->set_error_message("Failed to update LED state on the system.");
@@ -95,73 +510,426 @@ void LedManager::HandleUpdateRequest(const LedUpdateRequest &req, LedStateRespon
  * @param res The state response message to populate.
  */
 void LedManager::HandleQueryRequest(const LedQueryRequest& req, LedStateResponse* res) {
-    logger().Log("Received query for LED: " + req.led_num());
+    EchoLedId(req, res);
 
-    std::string state = GetLedState(req.led_num());
+    uint32_t led_id;
+    std::optional<hello_ipc::LedState> led_state;
+    if (RequestedLedId(req, &led_id)) {
+        logger().Log(LogId::kQueryReceived, led_id);
+        led_state = LookupLedState(led_id);
+    } else {
+        logger().Log(LogId::kQueryReceived, req.led_num());
+    }
+    SetQueryResult(req, led_state, res);
+}
 
-    res->set_led_num(req.led_num());
+/** 
+ * @brief Handles a BatchUpdateRequest.
+ * 
+ * Updates a bank of LEDs in one pass, with a single log line for the whole batch.
+ * The response holds one state entry per requested LED, in request order.
+ * 
+ * @param req The batch update request message.
+ * @param res The batch response message to populate.
+ */
+void LedManager::HandleBatchUpdateRequest(const BatchUpdateRequest &req, BatchStateResponse *res) {
+    int updated = 0;
+    for (const auto &update : req.updates()) {
+        LedStateResponse *state_res = res->add_states();
+        EchoLedId(update, state_res);
 
-    if (state == "on") {
-        res->set_state(hello_ipc::LedState::ON);
-    } else if (state == "off") {
-        res->set_state(hello_ipc::LedState::OFF);
-    } else {
-        res->set_error_message(state);
+        uint32_t led_id;
+        bool valid = RequestedLedId(update, &led_id);
+        if (!valid) {
+            logger().Log("Invalid LED number: " + update.led_num());
+        }
+        if (valid && StoreLedState(led_id, update.state())) {
+            state_res->set_state(update.state());
+            ++updated;
+        } else {
+            state_res->set_error_message("Failed to update LED state on the system.");
+        }
+    }
+
+    logger().Log(LogId::kBatchUpdated, updated, req.updates_size());
+}
+
+/** 
+ * @brief Handles a BatchQueryRequest.
+ * 
+ * Queries a bank of LEDs in one pass. The response holds one state entry per
+ * requested LED, in request order.
+ * 
+ * @param req The batch query request message.
+ * @param res The batch response message to populate.
+ */
+void LedManager::HandleBatchQueryRequest(const BatchQueryRequest &req, BatchStateResponse *res) {
+    logger().Log(LogId::kBatchQueryReceived, req.queries_size());
+
+    for (const auto &query : req.queries()) {
+        LedStateResponse *state_res = res->add_states();
+        EchoLedId(query, state_res);
+
+        uint32_t led_id;
+        std::optional<hello_ipc::LedState> led_state;
+        if (RequestedLedId(query, &led_id)) {
+            led_state = LookupLedState(led_id);
+        }
+        SetQueryResult(query, led_state, state_res);
+    }
+}
+
+/** 
+ * @brief Handles a StatsRequest.
+ * 
+ * Fills the response with a snapshot of the server's counters and per-stage
+ * latency percentiles.
+ * 
+ * @param req The stats request message.
+ * @param res The stats response message to populate.
+ */
+void LedManager::HandleStatsRequest(const StatsRequest &req, StatsResponse *res) {
+    (void)req; // No parameters yet
+
+    Metrics::Snapshot snapshot = metrics().Read();
+    res->set_update_requests(snapshot.counters[Metrics::kUpdateRequests]);
+    res->set_query_requests(snapshot.counters[Metrics::kQueryRequests]);
+    res->set_batch_update_requests(snapshot.counters[Metrics::kBatchUpdateRequests]);
+    res->set_batch_query_requests(snapshot.counters[Metrics::kBatchQueryRequests]);
+    res->set_stats_requests(snapshot.counters[Metrics::kStatsRequests]);
+    res->set_parse_failures(snapshot.counters[Metrics::kParseFailures]);
+    res->set_bytes_in(snapshot.counters[Metrics::kBytesIn]);
+    res->set_bytes_out(snapshot.counters[Metrics::kBytesOut]);
+    res->set_active_connections(snapshot.counters[Metrics::kActiveConnections]);
+    res->set_subscribe_requests(snapshot.counters[Metrics::kSubscribeRequests]);
+    res->set_notifications_sent(snapshot.counters[Metrics::kNotificationsSent]);
+    res->set_noop_updates(snapshot.counters[Metrics::kNoOpUpdates]);
+    res->set_compare_and_set_requests(snapshot.counters[Metrics::kCompareAndSetRequests]);
+    res->set_rejected_connections(snapshot.counters[Metrics::kRejectedConnections]);
+    res->set_overloaded_requests(snapshot.counters[Metrics::kOverloadedRequests]);
+    for (const auto &client : ClientQueueDepths()) {
+        auto *queue = res->add_client_queues();
+        queue->set_client_id(static_cast<uint32_t>(client.first));
+        queue->set_depth(static_cast<uint32_t>(client.second));
+    }
+
+    for (int i = 0; i < Metrics::kStageCount; ++i) {
+        const LatencyHistogram &histogram = snapshot.stages[i];
+        StageLatency *stage = res->add_stages();
+        stage->set_stage(Metrics::StageName(static_cast<Metrics::Stage>(i)));
+        stage->set_count(histogram.count());
+        stage->set_p50_ns(histogram.Percentile(50));
+        stage->set_p99_ns(histogram.Percentile(99));
+        stage->set_p999_ns(histogram.Percentile(99.9));
+        stage->set_max_ns(histogram.max());
+    }
+}
+
+/** 
+ * @brief Handles a SubscribeRequest.
+ * 
+ * Builds the subscription to the LEDs selected by the request. It is registered
+ * with AddSubscription() only once the response was sent, so the client gets the
+ * acknowledgement before any notification.
+ * 
+ * @param client_socket The socket the notifications are pushed to.
+ * @param request_id The id of the request, echoed in every notification.
+ * @param req The subscribe request message.
+ * @param res The subscribe response message to populate.
+ * @return The subscription, or nullptr if the filter is invalid.
+ */
+std::shared_ptr<LedManager::Subscription> LedManager::HandleSubscribeRequest(int client_socket, uint64_t request_id,
+                                                                             const SubscribeRequest &req,
+                                                                             SubscribeResponse *res) {
+    auto subscription = std::make_shared<Subscription>();
+    subscription->client_socket = client_socket;
+    subscription->request_id = request_id;
+
+    for (const auto &led_num : req.led_nums()) {
+        uint32_t led_id;
+        if (!ParseLedId(led_num, &led_id)) {
+            res->set_error_message("Invalid LED number: " + led_num);
+            return nullptr;
+        }
+        subscription->leds.insert(led_id);
+    }
+    subscription->leds.insert(req.led_ids().begin(), req.led_ids().end());
+    if (req.has_range()) {
+        if (req.range().first() > req.range().last()) {
+            res->set_error_message("Invalid LED range.");
+            return nullptr;
+        }
+        subscription->has_range = true;
+        subscription->first = req.range().first();
+        subscription->last = req.range().last();
+    }
+    return subscription;
+}
+
+/** 
+ * @brief Registers a subscription for notifications.
+ * 
+ * Replaces any earlier subscription of the same connection. Nothing is registered
+ * if the client is gone already.
+ * 
+ * @param subscription The subscription built by HandleSubscribeRequest().
+ */
+void LedManager::AddSubscription(std::shared_ptr<Subscription> subscription) {
+    // Pinning under the lock orders this against OnClientDisconnected(): a client that
+    // is already gone is not found, one that leaves later has its subscription dropped
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    subscription->connection = PinConnection(subscription->client_socket);
+    if (!subscription->connection) {
+        return;
+    }
+    int client_socket = subscription->client_socket;
+    subscriptions_[client_socket] = std::move(subscription);
+    subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
+    logger().Log("Client " + std::to_string(client_socket) + " subscribed to LED changes.");
+}
+
+/** 
+ * @brief Handles a CompareAndSetRequest.
+ * 
+ * Sets the LED to the desired state only if it currently has the expected one,
+ * so controllers can arbitrate in one round trip without losing updates.
+ * 
+ * @param req The compare-and-set request message.
+ * @param res The compare-and-set response message to populate.
+ */
+void LedManager::HandleCompareAndSetRequest(const CompareAndSetRequest &req, CompareAndSetResponse *res) {
+    res->set_led_id(req.led_id());
+
+    auto valid = [](hello_ipc::LedState led_state) {
+        return led_state == hello_ipc::LedState::ON || led_state == hello_ipc::LedState::OFF;
+    };
+    if (!valid(req.expected()) || !valid(req.desired())) {
+        res->set_error_message("Invalid LED state.");
+        return;
+    }
+
+    bool changed = false;
+    std::optional<hello_ipc::LedState> observed = CompareAndSetLedState(req.led_id(), req.expected(), req.desired(),
+                                                                        &changed);
+    if (!observed) {
+        res->set_error_message("error: LED not found");
+        return;
+    }
+    res->set_observed(*observed);
+    res->set_swapped(*observed == req.expected());
+    if (changed) {
+        logger().Log(LogId::kLedUpdated, req.led_id(), req.desired() == hello_ipc::LedState::ON ? "on" : "off");
+    }
+}
+
+/** 
+ * @brief Drops the subscription of a disconnected client.
+ * 
+ * @param client_socket The socket of the client that went away.
+ */
+void LedManager::OnClientDisconnected(int client_socket) {
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    if (subscriptions_.erase(client_socket) > 0) {
+        subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
     }
 }
 
 /** 
  * @brief Updates the state of a specific LED.
  * 
- * Writes the desired state to the LED's brightness file.
+ * Stores the desired state in the LED table and logs the change, if it is one.
+ * The brightness file is written later by the flusher thread.
  * 
  * @param led_num The number of the LED to update.
  * @param led_state The desired state of the LED (ON or OFF).
  * @return True if the update was successful, false otherwise.
  */
 bool LedManager::UpdateLedState(const std::string &led_num, hello_ipc::LedState led_state) {
-    if (led_num.empty()) {
-        logger().Log("Invalid empty LED number.");
+    bool changed = false;
+    if (!StoreLedState(led_num, led_state, &changed)) {
         return false;
     }
 
-    if (led_state != hello_ipc::LedState::ON && led_state != hello_ipc::LedState::OFF) {
-        logger().Log("Invalid LED state: " + std::to_string(static_cast<int>(led_state)));
+    if (changed) {
+        logger().Log(LogId::kLedUpdated, led_num, (led_state == hello_ipc::LedState::ON) ? "on" : "off");
+    }
+
+    return true;
+}
+
+/** 
+ * @brief Updates the state of a LED identified by its numeric id.
+ * 
+ * @param led_id The id of the LED to update.
+ * @param led_state The desired state of the LED (ON or OFF).
+ * @return True if the update was successful, false otherwise.
+ */
+bool LedManager::UpdateLedState(uint32_t led_id, hello_ipc::LedState led_state) {
+    bool changed = false;
+    if (!StoreLedState(led_id, led_state, &changed)) {
         return false;
     }
 
-    std::string ledDir = "/tmp/sys/class/led_" + led_num;
-    std::string filePath = ledDir + "/brightness";
+    if (changed) {
+        logger().Log(LogId::kLedUpdated, led_id, (led_state == hello_ipc::LedState::ON) ? "on" : "off");
+    }
 
-    std::error_code ec;
-    std::filesystem::create_directories(ledDir, ec);
-    if (ec) {
-        logger().Log("Error creating directory " + ledDir + ": " + ec.message());
+    return true;
+}
+
+/** 
+ * @brief Stores the state of a specific LED and queues it for the flusher.
+ * 
+ * Only failures are logged, so batches can report the outcome once.
+ * 
+ * @param led_num The number of the LED to update.
+ * @param led_state The desired state of the LED (ON or OFF).
+ * @param changed If not null, set to whether the LED had a different state before.
+ * @return True if the state was accepted, false otherwise.
+ */
+bool LedManager::StoreLedState(const std::string &led_num, hello_ipc::LedState led_state, bool *changed) {
+    if (led_num.empty()) {
+        logger().Log("Invalid empty LED number.");
         return false;
     }
 
-    std::ofstream ledFile(filePath);
-    if (!ledFile) {
-        logger().Log("Error opening file for writing: " + filePath);
+    uint32_t led_id;
+    if (!ParseLedId(led_num, &led_id)) {
+        logger().Log("Invalid LED number: " + led_num);
         return false;
     }
 
-    ledFile << (led_state == hello_ipc::LedState::ON ? "1" : "0") << '\n';
-    if (!ledFile) {
-        logger().Log("Error writing to file: " + filePath);
+    return StoreLedState(led_id, led_state, changed);
+}
+
+/** 
+ * @brief Stores the state of a LED identified by its numeric id.
+ * 
+ * @param led_id The id of the LED to update.
+ * @param led_state The desired state of the LED (ON or OFF).
+ * @param changed If not null, set to whether the LED had a different state before.
+ * @return True if the state was accepted, false otherwise.
+ */
+bool LedManager::StoreLedState(uint32_t led_id, hello_ipc::LedState led_state, bool *changed) {
+    if (led_state != hello_ipc::LedState::ON && led_state != hello_ipc::LedState::OFF) {
+        logger().Log("Invalid LED state: " + std::to_string(static_cast<int>(led_state)));
         return false;
     }
 
-    std::string led_state_str = (led_state == hello_ipc::LedState::ON) ? "on" : "off";
-    logger().Log("Updated LED " + led_num + " to state: " + led_state_str);
+    bool committed = CommitLedState(led_id, led_state);
+    if (changed) {
+        *changed = committed;
+    }
+    return true;
+}
 
+/** 
+ * @brief Stores a validated LED state, queues it for the flusher and notifies subscribers.
+ * 
+ * An update to the state the table already holds is a no-op: it is counted but
+ * neither written nor journaled, and subscribers are not notified. LEDs that
+ * are not in the table yet are always written.
+ * 
+ * @param led_id The id of the LED to update.
+ * @param led_state The new state, ON or OFF.
+ * @return false if the update was a no-op.
+ */
+bool LedManager::CommitLedState(uint32_t led_id, hello_ipc::LedState led_state) {
+    Shard &shard = ShardFor(led_id);
+    bool shard_was_clean;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto inserted = shard.leds.emplace(led_id, led_state);
+        if (!inserted.second) {
+            if (inserted.first->second == led_state) {
+                metrics().Add(Metrics::kNoOpUpdates);
+                return false;
+            }
+            inserted.first->second = led_state;
+        }
+        shard_was_clean = shard.dirty.empty();
+        shard.dirty[led_id] = led_state;
+    }
+    PublishChange(led_id, led_state, shard_was_clean);
     return true;
 }
 
+/** 
+ * @brief Sets a LED to desired if its state is expected, atomically under its shard lock.
+ * 
+ * A LED that is not in the table yet is loaded from its brightness file first.
+ * 
+ * @param led_id The id of the LED.
+ * @param expected The state the LED must have for the update to happen.
+ * @param desired The new state, ON or OFF.
+ * @param changed Set to whether the state changed; a swap to the state the LED
+ * already has is a no-op, counted like one of UpdateLedState().
+ * @return The state before the call, or nullopt if the LED is unknown.
+ */
+std::optional<hello_ipc::LedState> LedManager::CompareAndSetLedState(uint32_t led_id, hello_ipc::LedState expected,
+                                                                     hello_ipc::LedState desired, bool *changed) {
+    if (changed) {
+        *changed = false;
+    }
+    if (!LookupLedState(led_id)) {
+        return std::nullopt;
+    }
+
+    Shard &shard = ShardFor(led_id);
+    bool shard_was_clean;
+    hello_ipc::LedState observed;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.leds.find(led_id); // Entries are never removed, so the lookup's entry is still there
+        observed = it->second;
+        if (observed != expected) {
+            return observed;
+        }
+        if (desired == observed) {
+            metrics().Add(Metrics::kNoOpUpdates);
+            return observed;
+        }
+        it->second = desired;
+        shard_was_clean = shard.dirty.empty();
+        shard.dirty[led_id] = desired;
+    }
+    if (changed) {
+        *changed = true;
+    }
+    PublishChange(led_id, desired, shard_was_clean);
+    return observed;
+}
+
+/** 
+ * @brief Hands a committed change to the flusher and the subscribers.
+ * 
+ * @param led_id The id of the changed LED.
+ * @param led_state The new state.
+ * @param shard_was_clean Whether the change made its shard dirty.
+ */
+void LedManager::PublishChange(uint32_t led_id, hello_ipc::LedState led_state, bool shard_was_clean) {
+    if (shard_was_clean) {
+        // A dirty shard always has a flush pending, so only the first change takes this lock
+        bool wake_flusher;
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            wake_flusher = !flush_pending_;
+            flush_pending_ = true;
+        }
+        if (wake_flusher) {
+            flush_cv_.notify_one();
+        }
+    }
+    if (subscription_count_.load(std::memory_order_relaxed) > 0) {
+        QueueNotification(led_id, led_state);
+    }
+}
+
 /** 
  * @brief Retrieves the current state of a specific LED.
  * 
- * Reads the brightness file of the LED and returns its state as a string.
+ * Served from the LED table. A LED that is not in the table yet is loaded
+ * once from its brightness file.
  * 
  * @param led_num The number of the LED to query.
  * @return A string representing the LED state ("on", "off", or an error message).
@@ -171,20 +939,352 @@ std::string LedManager::GetLedState(const std::string &led_num) const {
         return "error: LED number cannot be empty";
     }
 
-    if (!std::filesystem::exists("/tmp/sys/class/led_" + led_num)) {
+    uint32_t led_id;
+    if (!ParseLedId(led_num, &led_id)) {
         return "error: LED not found";
     }
 
-    std::string filePath = "/tmp/sys/class/led_" + led_num + "/brightness";
-    std::ifstream ledFile(filePath);
+    std::optional<hello_ipc::LedState> led_state = LookupLedState(led_id);
+    if (!led_state) {
+        return "error: LED not found";
+    }
+    return (*led_state == hello_ipc::LedState::ON) ? "on" : "off";
+}
 
-    if (!ledFile.is_open())
-        return "error";
+/** 
+ * @brief Looks up the state of a LED by its id.
+ * 
+ * A LED that is not in the table yet is loaded once from its brightness file.
+ * 
+ * @param led_id The id of the LED.
+ * @return The state, or nullopt if the LED is unknown.
+ */
+std::optional<hello_ipc::LedState> LedManager::LookupLedState(uint32_t led_id) const {
+    Shard &shard = ShardFor(led_id);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.leds.find(led_id);
+        if (it != shard.leds.end()) {
+            return it->second;
+        }
+    }
+
+    hello_ipc::LedState led_state;
+    if (!LoadLedState(led_id, &led_state)) {
+        return std::nullopt;
+    }
 
-    std::string state;
-    std::getline(ledFile, state);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // An update may have raced with the load; the table entry wins.
+    return shard.leds.emplace(led_id, led_state).first->second;
+}
 
-    return (state == "1") ? "on" : "off";
+/** 
+ * @brief Reads the state of a LED from its brightness file.
+ * 
+ * @param led_id The id of the LED to read.
+ * @param led_state Receives the state.
+ * @return false if the LED has no brightness file.
+ */
+bool LedManager::LoadLedState(uint32_t led_id, hello_ipc::LedState *led_state) const {
+    char value;
+    if (!files_.Read(led_id, &value)) {
+        return false;
+    }
+
+    *led_state = (value == '1') ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF;
+    return true;
+}
+
+/** 
+ * @brief Writes the state of a LED to its brightness file.
+ * 
+ * @param led_id The id of the LED to write.
+ * @param led_state The state to write.
+ * @return True if the write was successful, false otherwise.
+ */
+bool LedManager::WriteBrightnessFile(uint32_t led_id, hello_ipc::LedState led_state) {
+    if (!files_.Write(led_id, led_state == hello_ipc::LedState::ON ? '1' : '0')) {
+        logger().Log("Error writing brightness file of LED " + std::to_string(led_id));
+        return false;
+    }
+
+    return true;
+}
+
+/** 
+ * @brief Writes every pending state change to the brightness files.
+ * 
+ * The caller must hold write_mutex_, so changes taken from the pending sets are
+ * always on disk once another writer gets the mutex. Being the only writer also
+ * means a brightness file never sees two concurrent writes. Shards are drained one
+ * at a time, so updates only wait for the swap of their own shard.
+ */
+void LedManager::WritePendingStates() {
+    std::unordered_map<uint32_t, hello_ipc::LedState> pending;
+    for (Shard &shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.dirty.empty()) {
+                continue;
+            }
+            pending.swap(shard.dirty);
+        }
+
+        if (store_ && !store_->Append(pending)) {
+            logger().Log("Error appending to the journal of " + store_->snapshot_path());
+        }
+        for (const auto &entry : pending) {
+            WriteBrightnessFile(entry.first, entry.second);
+        }
+        pending.clear();
+    }
+}
+
+/** 
+ * @brief Replaces the snapshot with the written LED states and empties the journal.
+ * 
+ * The caller must hold write_mutex_. LEDs with a pending change are left out: their
+ * files do not hold the new state yet and it is not journaled, so after a crash they
+ * are read from their brightness files again instead of being restored as applied.
+ * Their pending changes reach the new journal with the next WritePendingStates().
+ */
+void LedManager::WriteCheckpoint() {
+    std::vector<std::pair<uint32_t, hello_ipc::LedState>> states;
+    for (Shard &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto &entry : shard.leds) {
+            if (shard.dirty.count(entry.first) == 0) {
+                states.push_back(entry);
+            }
+        }
+    }
+
+    last_checkpoint_ = std::chrono::steady_clock::now();
+    if (!store_->Checkpoint(states)) {
+        logger().Log("Error writing snapshot " + store_->snapshot_path());
+    }
+}
+
+/** 
+ * @brief Writes every pending state change before returning.
+ */
+void LedManager::Flush() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    WritePendingStates();
+}
+
+/** 
+ * @brief Folds the journal into a new snapshot now, without waiting for the flusher.
+ * 
+ * Does nothing unless EnableStateStore() succeeded.
+ */
+void LedManager::Checkpoint() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (store_) {
+        WriteCheckpoint();
+    }
+}
+
+/** 
+ * @brief Restores the LED table from a snapshot and journal and persists it from now on.
+ * 
+ * Restored LEDs are served from the table right away, so a restart does not
+ * probe the brightness file of every LED on its first query. Journaled changes
+ * are queued for the flusher again: the server may have stopped after journaling
+ * them but before writing the brightness files. Snapshot entries were written
+ * before the snapshot was taken, so their files are left as they are.
+ * 
+ * @param snapshot_path The snapshot file; the journal is kept next to it.
+ * @return false if the files cannot be used, in which case nothing is persisted.
+ */
+bool LedManager::EnableStateStore(const std::string &snapshot_path) {
+    auto store = std::make_unique<LedStateStore>(snapshot_path);
+    std::size_t restored = 0;
+    std::string error;
+    bool journaled_changes = false;
+    bool opened = store->Open([this, &restored, &journaled_changes](uint32_t led_id, hello_ipc::LedState led_state,
+                                                                   bool journaled) {
+        Shard &shard = ShardFor(led_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.leds[led_id] = led_state;
+        if (journaled) {
+            shard.dirty[led_id] = led_state;
+            journaled_changes = true;
+        }
+        ++restored;
+    }, &error);
+    if (!opened) {
+        logger().Log("State store disabled: " + error);
+        return false;
+    }
+
+    logger().Log("Replayed " + std::to_string(restored) + " stored LED states from " + snapshot_path);
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        store_ = std::move(store);
+        last_checkpoint_ = std::chrono::steady_clock::now();
+    }
+    if (journaled_changes) {
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            flush_pending_ = true;
+        }
+        flush_cv_.notify_one();
+    }
+    return true;
+}
+
+/** 
+ * @brief Flusher thread loop, writes pending state changes until the manager is destroyed.
+ * 
+ * After the first pending change it waits briefly, so repeated updates of the
+ * same LED are merged into a single file write.
+ */
+void LedManager::FlushLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex_);
+            flush_cv_.wait(lock, [this]() { return stopping_ || flush_pending_; });
+            if (!flush_pending_) {
+                return; // Stopping and nothing left to write
+            }
+            flush_cv_.wait_for(lock, kFlushDelay, [this]() { return stopping_; });
+            flush_pending_ = false; // Shards dirtied from now on request another pass
+        }
+
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        WritePendingStates();
+        if (store_ && (store_->journal_entries() >= kCheckpointEntries ||
+                       std::chrono::steady_clock::now() - last_checkpoint_ >= kCheckpointInterval)) {
+            WriteCheckpoint();
+        }
+    }
+}
+
+/**
+ * @brief Records a committed change for the notifier.
+ *
+ * Repeated changes of a LED before the notifier picks them up keep only the latest state.
+ *
+ * @param led_id The id of the changed LED.
+ * @param led_state Its new state.
+ */
+void LedManager::QueueNotification(uint32_t led_id, hello_ipc::LedState led_state) {
+    bool wake_notifier;
+    {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        wake_notifier = changes_.empty();
+        changes_[led_id] = led_state;
+    }
+    if (wake_notifier) {
+        notify_cv_.notify_one();
+    }
+}
+
+/**
+ * @brief Pushes the collected changes to the subscribers until the LedManager is destroyed.
+ *
+ * The sends happen without the lock, so updates keep collecting changes meanwhile.
+ * While a subscriber has a backlog, the loop also wakes up every kNotifyRetryDelay
+ * to see whether the subscriber caught up.
+ */
+void LedManager::NotifyLoop() {
+    std::unordered_map<uint32_t, hello_ipc::LedState> changes;
+    std::vector<std::shared_ptr<Subscription>> subscriptions;
+    bool backlog = false;
+
+    std::unique_lock<std::mutex> lock(notify_mutex_);
+    while (true) {
+        auto woken = [this]() { return notifier_stopping_ || !changes_.empty(); };
+        if (backlog) {
+            notify_cv_.wait_for(lock, kNotifyRetryDelay, woken);
+        } else {
+            notify_cv_.wait(lock, woken);
+        }
+        if (notifier_stopping_) {
+            return;
+        }
+        changes.swap(changes_);
+        for (const auto &entry : subscriptions_) {
+            subscriptions.push_back(entry.second);
+        }
+        lock.unlock();
+
+        backlog = SendNotifications(changes, subscriptions);
+        changes.clear();
+        subscriptions.clear();
+
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Adds the changes to the backlog of every matching subscriber and sends the backlogs.
+ *
+ * A backlog holds the latest state per LED, so a subscriber that does not keep up
+ * gets fewer notifications rather than a growing queue. It is only sent while the
+ * server holds less than kMaxUnsentNotificationBytes for the client, which keeps
+ * the notifier from ever waiting on one client. A subscriber whose backlog passes
+ * kMaxPendingNotifications LEDs is dropped.
+ *
+ * @param changes The latest state of every changed LED.
+ * @param subscriptions The subscribers at the time the changes were taken.
+ * @return true if some subscriber still has a backlog.
+ */
+bool LedManager::SendNotifications(const std::unordered_map<uint32_t, hello_ipc::LedState> &changes,
+                                   const std::vector<std::shared_ptr<Subscription>> &subscriptions) {
+    hello_ipc::Response notification;
+    std::string message;
+    bool backlog = false;
+    for (const auto &subscription : subscriptions) {
+        for (const auto &change : changes) {
+            if (subscription->Matches(change.first)) {
+                subscription->pending[change.first] = change.second;
+            }
+        }
+        if (subscription->pending.empty()) {
+            continue;
+        }
+        if (subscription->pending.size() > kMaxPendingNotifications) {
+            DropSubscription(subscription);
+            continue;
+        }
+        if (UnsentBytes(subscription->client_socket) >= kMaxUnsentNotificationBytes) {
+            backlog = true; // The client is behind, try again once it read more
+            continue;
+        }
+
+        notification.set_request_id(subscription->request_id);
+        for (const auto &change : subscription->pending) {
+            auto *state_res = notification.mutable_state_response();
+            state_res->set_led_id(change.first);
+            state_res->set_led_num(std::to_string(change.first)); // For watchers that predate led_id
+            state_res->set_state(change.second);
+            notification.SerializeToString(&message);
+            SendResponse(subscription->client_socket, message);
+            metrics().Add(Metrics::kNotificationsSent);
+        }
+        subscription->pending.clear();
+    }
+    return backlog;
+}
+
+/**
+ * @brief Forgets a subscriber that fell too far behind. Its connection stays open.
+ *
+ * @param subscription The subscription, unless the client replaced or dropped it already.
+ */
+void LedManager::DropSubscription(const std::shared_ptr<Subscription> &subscription) {
+    subscription->pending.clear();
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    auto it = subscriptions_.find(subscription->client_socket);
+    if (it != subscriptions_.end() && it->second == subscription) {
+        subscriptions_.erase(it);
+        subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
+        logger().Log("Dropped the subscription of client " + std::to_string(subscription->client_socket) +
+                     ", it does not read its notifications.");
+    }
 }
 
 } // namespace hello_ipc
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "LedStateStore.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hello_ipc {
+
+namespace {
+
+const uint32_t kSnapshotMagic = 0x484c5353; // "HLSS"
+const uint32_t kJournalMagic = 0x484c534a;  // "HLSJ"
+const uint32_t kFormatVersion = 1;
+const uint8_t kEntryMarker = 0xa5;          // Tells a written entry from zeroed space after a crash
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t generation;
+    uint64_t count; // Entries in a snapshot, 0 in a journal
+};
+
+struct Entry {
+    uint32_t led_id;
+    uint8_t state;
+    uint8_t marker;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24, "FileHeader must have no padding");
+static_assert(sizeof(Entry) == 8, "Entry must have no padding");
+
+Entry MakeEntry(uint32_t led_id, hello_ipc::LedState led_state) {
+    return {led_id, static_cast<uint8_t>(led_state == hello_ipc::LedState::ON ? 1 : 0), kEntryMarker, 0};
+}
+
+bool IsValid(const Entry &entry) {
+    return entry.marker == kEntryMarker && entry.state <= 1;
+}
+
+hello_ipc::LedState StateOf(const Entry &entry) {
+    return entry.state ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF;
+}
+
+bool WriteAll(int fd, const char *data, std::size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        len -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+// Read-only private mapping of a whole file, unmapped when it goes out of scope.
+class FileMapping {
+    public:
+        FileMapping(int fd, std::size_t size) : size_(size) {
+            data_ = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            if (data_ != MAP_FAILED) {
+                madvise(data_, size, MADV_SEQUENTIAL);
+            }
+        }
+        ~FileMapping() {
+            if (data_ != MAP_FAILED) {
+                munmap(data_, size_);
+            }
+        }
+
+        bool ok() const { return data_ != MAP_FAILED; }
+        const char *data() const { return static_cast<const char *>(data_); }
+
+    private:
+        void *data_;
+        std::size_t size_;
+};
+
+} // namespace
+
+/**
+ * @brief Constructs a store for the snapshot at snapshot_path; nothing is opened yet.
+ *
+ * @param snapshot_path The snapshot file. The journal is snapshot_path + ".journal".
+ */
+LedStateStore::LedStateStore(const std::string &snapshot_path)
+    : snapshot_path_(snapshot_path), journal_path_(snapshot_path + ".journal") {}
+
+/**
+ * @brief Closes the journal.
+ */
+LedStateStore::~LedStateStore() {
+    if (journal_fd_ >= 0) {
+        close(journal_fd_);
+    }
+}
+
+/**
+ * @brief Restores the stored LED states and prepares the journal for appending.
+ *
+ * A missing snapshot is an empty one. A journal of an older generation is
+ * discarded because the snapshot already holds its changes.
+ *
+ * @param restore Called for every stored state, the snapshot first, then the journal in order.
+ * @param error Receives the reason if false is returned.
+ * @return false if a file cannot be read or written, or the snapshot is corrupt.
+ */
+bool LedStateStore::Open(const RestoreCallback &restore, std::string *error) {
+    return ReplaySnapshot(restore, error) && ReplayJournal(restore, error);
+}
+
+bool LedStateStore::ReplaySnapshot(const RestoreCallback &restore, std::string *error) {
+    int fd = open(snapshot_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            generation_ = 0;
+            return true;
+        }
+        *error = "Cannot open " + snapshot_path_ + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FileHeader);
+    std::size_t size = ok ? static_cast<std::size_t>(st.st_size) : 0;
+    FileMapping mapping(fd, size);
+    close(fd);
+    if (!ok || !mapping.ok()) {
+        *error = "Cannot map " + snapshot_path_;
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, mapping.data(), sizeof(header));
+    if (header.magic != kSnapshotMagic || header.version != kFormatVersion ||
+        header.count != (size - sizeof(header)) / sizeof(Entry) ||
+        (size - sizeof(header)) % sizeof(Entry) != 0) {
+        *error = "Invalid snapshot header in " + snapshot_path_;
+        return false;
+    }
+
+    // Validate everything first so a corrupt snapshot restores nothing
+    const Entry *entries = reinterpret_cast<const Entry *>(mapping.data() + sizeof(header));
+    for (uint64_t i = 0; i < header.count; ++i) {
+        if (!IsValid(entries[i])) {
+            *error = "Corrupt entry " + std::to_string(i) + " in " + snapshot_path_;
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header.count; ++i) {
+        restore(entries[i].led_id, StateOf(entries[i]), false);
+    }
+    generation_ = header.generation;
+    return true;
+}
+
+bool LedStateStore::ReplayJournal(const RestoreCallback &restore, std::string *error) {
+    journal_fd_ = open(journal_path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (journal_fd_ < 0) {
+        *error = "Cannot open " + journal_path_ + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(journal_fd_, &st) < 0) {
+        *error = "Cannot stat " + journal_path_ + ": " + strerror(errno);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size < sizeof(FileHeader)) {
+        return ResetJournal(); // New, or cut short while being reset
+    }
+
+    FileMapping mapping(journal_fd_, size);
+    if (!mapping.ok()) {
+        *error = "Cannot map " + journal_path_;
+        return false;
+    }
+    FileHeader header;
+    memcpy(&header, mapping.data(), sizeof(header));
+    if (header.magic != kJournalMagic || header.version != kFormatVersion) {
+        *error = "Invalid journal header in " + journal_path_;
+        return false;
+    }
+    if (header.generation != generation_) {
+        return ResetJournal(); // Written before the current snapshot
+    }
+
+    const Entry *entries = reinterpret_cast<const Entry *>(mapping.data() + sizeof(header));
+    std::size_t count = (size - sizeof(header)) / sizeof(Entry);
+    std::size_t valid = 0;
+    while (valid < count && IsValid(entries[valid])) {
+        restore(entries[valid].led_id, StateOf(entries[valid]), true);
+        ++valid;
+    }
+    journal_entries_ = valid;
+
+    // Drop a torn tail so new entries line up again
+    std::size_t valid_size = sizeof(header) + valid * sizeof(Entry);
+    if (valid_size != size && ftruncate(journal_fd_, static_cast<off_t>(valid_size)) < 0) {
+        *error = "Cannot truncate " + journal_path_ + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool LedStateStore::ResetJournal() {
+    FileHeader header = {kJournalMagic, kFormatVersion, generation_, 0};
+    journal_entries_ = 0;
+    return ftruncate(journal_fd_, 0) == 0 &&
+           WriteAll(journal_fd_, reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+/**
+ * @brief Appends changes to the journal.
+ *
+ * @param changes The latest state of every changed LED.
+ * @return false if the journal is not open or the write failed.
+ */
+bool LedStateStore::Append(const std::unordered_map<uint32_t, hello_ipc::LedState> &changes) {
+    if (journal_fd_ < 0) {
+        return false;
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(changes.size());
+    for (const auto &change : changes) {
+        entries.push_back(MakeEntry(change.first, change.second));
+    }
+    if (!WriteAll(journal_fd_, reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry))) {
+        return false;
+    }
+    journal_entries_ += entries.size();
+    return true;
+}
+
+/**
+ * @brief Writes a new snapshot and empties the journal.
+ *
+ * The snapshot is written to a temporary file and renamed over the old one, so
+ * a crash leaves either the old or the new snapshot in place.
+ *
+ * @param states Every LED state to keep.
+ * @return false if the snapshot could not be written; the old files stay valid.
+ */
+bool LedStateStore::Checkpoint(const std::vector<std::pair<uint32_t, hello_ipc::LedState>> &states) {
+    if (journal_fd_ < 0) {
+        return false;
+    }
+
+    std::vector<char> buffer(sizeof(FileHeader) + states.size() * sizeof(Entry));
+    FileHeader header = {kSnapshotMagic, kFormatVersion, generation_ + 1, states.size()};
+    memcpy(buffer.data(), &header, sizeof(header));
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        Entry entry = MakeEntry(states[i].first, states[i].second);
+        memcpy(buffer.data() + sizeof(header) + i * sizeof(Entry), &entry, sizeof(entry));
+    }
+
+    std::string temp_path = snapshot_path_ + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = WriteAll(fd, buffer.data(), buffer.size()) && fdatasync(fd) == 0;
+    close(fd);
+    if (!written || std::rename(temp_path.c_str(), snapshot_path_.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    ++generation_;
+    return ResetJournal();
+}
+
+} // namespace hello_ipc
@@ -0,0 +1,266 @@
+#include "LoadGenerator.hpp"
+#include "CompactMessage.hpp"
+#include "Service.hpp"
+#include "led_service.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace hello_ipc {
+
+namespace {
+
+// One client connection, framed like UpdateLed and QueryLed.
+class LoadConnection : public Service {
+    public:
+        LoadConnection() : Service("LoadGenerator", false) {}
+        using Service::ConnectToServer;
+        using Service::SetWireFormat;
+};
+
+// Draws keys in [0, keys) with probability proportional to 1 / (rank + 1)^skew.
+class ZipfGenerator {
+    public:
+        ZipfGenerator(uint32_t keys, double skew, uint64_t seed)
+            : rng_(seed), uniform_(0.0, 1.0), keys_(std::max<uint32_t>(keys, 1)) {
+            if (skew <= 0.0) {
+                return;
+            }
+            cdf_.resize(keys_);
+            double sum = 0.0;
+            for (uint32_t i = 0; i < keys_; ++i) {
+                sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+                cdf_[i] = sum;
+            }
+            for (double &value : cdf_) {
+                value /= sum;
+            }
+        }
+
+        uint32_t Next() {
+            if (cdf_.empty()) {
+                return static_cast<uint32_t>(rng_() % keys_);
+            }
+            auto it = std::lower_bound(cdf_.begin(), cdf_.end(), uniform_(rng_));
+            return static_cast<uint32_t>(std::min<std::size_t>(it - cdf_.begin(), keys_ - 1));
+        }
+
+        double Uniform() { return uniform_(rng_); }
+
+    private:
+        std::mt19937_64 rng_;
+        std::uniform_real_distribution<double> uniform_;
+        uint32_t keys_;
+        std::vector<double> cdf_;
+};
+
+bool ParseNumber(const char *text, double *value) {
+    char *end = nullptr;
+    *value = std::strtod(text, &end);
+    return end != text && *end == '\0' && *value >= 0.0;
+}
+
+} // namespace
+
+/**
+ * @brief Parses the load generator options.
+ *
+ * Every option but "--compact" takes a value; "--load-gen" itself is skipped.
+ *
+ * @param argc The argument count from the command line.
+ * @param argv The argument vector from the command line.
+ * @param options Receives the options, keeps the defaults of options not given.
+ * @return false if an option is unknown or has an invalid value.
+ */
+bool LoadGenerator::ParseArguments(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--load-gen") {
+            continue;
+        }
+        if (arg == "--compact") {
+            options->compact = true;
+            continue;
+        }
+
+        double value;
+        if (i + 1 >= argc || !ParseNumber(argv[i + 1], &value)) {
+            return false;
+        }
+        ++i;
+
+        if (arg == "--connections" && value >= 1) {
+            options->connections = static_cast<std::size_t>(value);
+        } else if (arg == "--update-ratio" && value <= 1.0) {
+            options->update_ratio = value;
+        } else if (arg == "--keys" && value >= 1 && value <= UINT32_MAX) {
+            options->keys = static_cast<uint32_t>(value);
+        } else if (arg == "--zipf") {
+            options->zipf_skew = value;
+        } else if (arg == "--rate") {
+            options->rate = value;
+        } else if (arg == "--duration" && value > 0.0) {
+            options->duration_s = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Constructs a load generator for the server at socket_path.
+ */
+LoadGenerator::LoadGenerator(const std::string &socket_path, const Options &options)
+    : socket_path_(socket_path), options_(options) {}
+
+/**
+ * @brief Runs every connection for the configured duration and merges their results.
+ *
+ * @return false if no connection could be established.
+ */
+bool LoadGenerator::Run() {
+    std::vector<Report> reports(options_.connections);
+    std::vector<std::thread> threads;
+    threads.reserve(options_.connections);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < options_.connections; ++i) {
+        threads.emplace_back([this, i, &reports]() { RunConnection(i, &reports[i]); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    report_ = Report();
+    report_.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const Report &report : reports) {
+        report_.requests += report.requests;
+        report_.errors += report.errors;
+        report_.latency_ns.Merge(report.latency_ns);
+    }
+    return report_.requests > 0 || report_.errors < options_.connections;
+}
+
+/**
+ * @brief Sends requests on one connection until the run is over.
+ *
+ * @param index The connection number, used to seed its random generators.
+ * @param report Receives the results of this connection.
+ */
+void LoadGenerator::RunConnection(std::size_t index, Report *report) {
+    LoadConnection conn;
+    if (options_.compact) {
+        conn.SetWireFormat(Service::WireFormat::kCompact);
+    }
+    if (!conn.ConnectToServer(socket_path_)) {
+        ++report->errors;
+        return;
+    }
+
+    ZipfGenerator keys(options_.keys, options_.zipf_skew, 0x9e3779b97f4a7c15ULL * (index + 1));
+    bool open_loop = options_.rate > 0.0;
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(open_loop ? options_.connections / options_.rate : 0.0));
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options_.duration_s));
+    // Spread the open-loop connections over one interval instead of sending in bursts
+    auto next_send = start + interval * index / options_.connections;
+
+    hello_ipc::Request req;
+    hello_ipc::Response res;
+    CompactMessage compact_req;
+    CompactMessage compact_res;
+    std::string message;
+    uint64_t request_id = 1;
+
+    while (true) {
+        std::chrono::steady_clock::time_point intended;
+        if (open_loop) {
+            if (next_send >= deadline) {
+                break;
+            }
+            std::this_thread::sleep_until(next_send);
+            intended = next_send;
+            next_send += interval;
+        } else {
+            intended = std::chrono::steady_clock::now();
+            if (intended >= deadline) {
+                break;
+            }
+        }
+
+        uint64_t id = request_id++;
+        uint32_t led_id = keys.Next();
+        bool update = keys.Uniform() < options_.update_ratio;
+        bool on = keys.Uniform() < 0.5;
+        if (options_.compact) {
+            compact_req.opcode = update ? CompactOpcode::kUpdate : CompactOpcode::kQuery;
+            compact_req.on = on;
+            compact_req.led_id = led_id;
+            compact_req.request_id = id;
+            message.resize(kCompactMessageSize);
+            EncodeCompactMessage(compact_req, &message[0]);
+        } else {
+            req.Clear();
+            req.set_request_id(id);
+            if (update) {
+                auto *update_req = req.mutable_update_request();
+                update_req->set_led_id(led_id);
+                update_req->set_state(on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+            } else {
+                req.mutable_query_request()->set_led_id(led_id);
+            }
+            req.SerializeToString(&message);
+        }
+        conn.SendMessage(message);
+
+        auto response = conn.ReceiveMessage();
+        if (!response) {
+            ++report->errors; // The connection is gone
+            return;
+        }
+        auto latency = std::chrono::steady_clock::now() - intended;
+        bool valid = options_.compact
+                         ? DecodeCompactMessage(*response, &compact_res) && compact_res.request_id == id
+                         : res.ParseFromString(*response) && res.request_id() == id;
+        if (!valid) {
+            ++report->errors;
+            continue;
+        }
+
+        ++report->requests;
+        report->latency_ns.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+    }
+}
+
+/**
+ * @brief Prints the throughput and latency percentiles of the last run.
+ */
+void LoadGenerator::PrintReport(std::ostream &out) const {
+    auto micros = [this](double percentile) {
+        return static_cast<double>(report_.latency_ns.Percentile(percentile)) / 1000.0;
+    };
+    double throughput = report_.elapsed_s > 0.0 ? report_.requests / report_.elapsed_s : 0.0;
+
+    out << std::fixed << std::setprecision(1)
+        << "Mode:       " << (options_.rate > 0.0 ? "open-loop" : "closed-loop") << ", "
+        << options_.connections << " connections" << (options_.compact ? ", compact format" : "") << "\n"
+        << "Requests:   " << report_.requests << " (" << report_.errors << " errors) in "
+        << std::setprecision(2) << report_.elapsed_s << " s\n"
+        << "Throughput: " << std::setprecision(0) << throughput << " req/s\n"
+        << std::setprecision(1)
+        << "Latency:    p50 " << micros(50) << " us, p99 " << micros(99) << " us, p99.9 "
+        << micros(99.9) << " us, max " << static_cast<double>(report_.latency_ns.max()) / 1000.0 << " us\n";
+}
+
+} // namespace hello_ipc
@@ -0,0 +1,132 @@
+#include "LogRecord.hpp"
+
+namespace hello_ipc {
+
+namespace {
+
+const char *const kLogFormats[] = {
+    "{}",                                          // kMessage
+    "Received update for LED: {} to state: {}",    // kUpdateReceived
+    "Received query for LED: {}",                  // kQueryReceived
+    "Updated LED {} to state: {}",                 // kLedUpdated
+    "Batch update: {} of {} LEDs updated",         // kBatchUpdated
+    "Received batch query for {} LEDs",            // kBatchQueryReceived
+    "Sent update for LED {} to state: {}",         // kUpdateSent
+    "Sent {} pipelined updates to state: {}",      // kUpdatesSent
+    "Sent query for LED {}",                       // kQuerySent
+    "Received response {} for LED {}: {}",         // kStateResponseReceived
+};
+
+static_assert(sizeof(kLogFormats) / sizeof(kLogFormats[0]) == static_cast<std::size_t>(LogId::kCount),
+              "Every LogId needs a format string");
+
+/**
+ * @brief Appends the text of the argument at pos and advances pos past it.
+ *
+ * @return false if the argument is malformed.
+ */
+bool FormatArgument(const char *args, std::size_t size, std::size_t &pos, std::string &out) {
+    if (pos >= size) {
+        return false;
+    }
+    char tag = args[pos++];
+    if (tag == 's') {
+        uint16_t length;
+        if (pos + sizeof(length) > size) {
+            return false;
+        }
+        memcpy(&length, args + pos, sizeof(length));
+        pos += sizeof(length);
+        if (pos + length > size) {
+            return false;
+        }
+        out.append(args + pos, length);
+        pos += length;
+        return true;
+    }
+
+    uint64_t raw;
+    if ((tag != 'i' && tag != 'u') || pos + sizeof(raw) > size) {
+        return false;
+    }
+    memcpy(&raw, args + pos, sizeof(raw));
+    pos += sizeof(raw);
+    out += (tag == 'i') ? std::to_string(static_cast<int64_t>(raw)) : std::to_string(raw);
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Returns the format string of a log id.
+ *
+ * @param id The format id.
+ * @return The format string, or nullptr if id is unknown.
+ */
+const char *LogFormatString(LogId id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    return index < static_cast<std::size_t>(LogId::kCount) ? kLogFormats[index] : nullptr;
+}
+
+/**
+ * @brief Encodes a log record.
+ *
+ * @param id The format id.
+ * @param timestamp_ns Wall clock time of the record in nanoseconds.
+ * @param args The encoded arguments.
+ * @param out Receives the record, must hold kLogRecordMaxSize bytes.
+ * @return The size of the record.
+ */
+std::size_t EncodeLogRecord(LogId id, uint64_t timestamp_ns, const LogArgs &args, char *out) {
+    uint16_t raw_id = static_cast<uint16_t>(id);
+    memcpy(out, &raw_id, sizeof(raw_id));
+    memcpy(out + sizeof(raw_id), &timestamp_ns, sizeof(timestamp_ns));
+    memcpy(out + kLogRecordHeaderSize, args.data(), args.size());
+    return kLogRecordHeaderSize + args.size();
+}
+
+/**
+ * @brief Formats a log record as text.
+ *
+ * Placeholders without a matching argument are printed as "?".
+ *
+ * @param record The encoded record.
+ * @param size Size of the record.
+ * @param out Receives the text.
+ * @param timestamp_ns If not null, receives the timestamp of the record.
+ * @return false if the record is malformed.
+ */
+bool FormatLogRecord(const char *record, std::size_t size, std::string &out, uint64_t *timestamp_ns) {
+    if (size < kLogRecordHeaderSize) {
+        return false;
+    }
+    uint16_t raw_id;
+    memcpy(&raw_id, record, sizeof(raw_id));
+    if (timestamp_ns != nullptr) {
+        memcpy(timestamp_ns, record + sizeof(raw_id), sizeof(*timestamp_ns));
+    }
+
+    const char *format = LogFormatString(static_cast<LogId>(raw_id));
+    if (format == nullptr) {
+        return false;
+    }
+
+    const char *args = record + kLogRecordHeaderSize;
+    std::size_t args_size = size - kLogRecordHeaderSize;
+    std::size_t pos = 0;
+    for (const char *p = format; *p != '\0'; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (pos >= args_size) {
+                out += '?';
+            } else if (!FormatArgument(args, args_size, pos, out)) {
+                return false;
+            }
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+    return true;
+}
+
+} // namespace hello_ipc
@@ -1,48 +1,293 @@
 #include "Logger.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace hello_ipc {
 
+namespace {
+
+const std::size_t kRingSlots = 4096;        // Power of two
+const std::size_t kBatchBytes = 64 * 1024;  // Size of one write() by the background thread
+
+/**
+ * @brief Writes all of data, retrying on partial writes and EINTR.
+ */
+void WriteAll(int fd, const char *data, std::size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Bounded multi-producer/single-consumer ring of fixed-size encoded log records.
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer holding ticket pos (sequence == pos) or readable by the consumer
+ * (sequence == pos + 1), so producers only contend on one atomic increment.
+ */
+struct Logger::AsyncRing {
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        uint16_t length;
+        char data[kLogRecordMaxSize];
+    };
+
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<uint64_t> enqueue_pos{0};
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    alignas(64) std::atomic<bool> writer_sleeping{false};
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable flushed_cv;
+    uint64_t written_pos = 0; // Guarded by mutex
+    bool stopping = false;    // Guarded by mutex
+    std::thread writer;
+
+    AsyncRing() : slots(kRingSlots) {
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Push(const char *record, std::size_t length) {
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[pos & (kRingSlots - 1)];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (sequence < pos) {
+                return false; // Full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        memcpy(slot->data, record, length);
+        slot->length = static_cast<uint16_t>(length);
+        // Sequentially consistent so the writer_sleeping check below cannot pass this store
+        slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+
+        if (writer_sleeping.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            work_cv.notify_one();
+        }
+        return true;
+    }
+
+    bool Readable(uint64_t pos) const {
+        return slots[pos & (kRingSlots - 1)].sequence.load(std::memory_order_seq_cst) == pos + 1;
+    }
+};
+
 /**
  * @brief Constructs a Logger for the given service name.
  *        The log file will be /tmp/<service_name>.log
  */
-Logger::Logger(const std::string &service_name)
-    : service_name_(service_name) {
+Logger::Logger(const std::string &service_name, Mode mode, Format format)
+    : service_name_(service_name), prefix_("[" + service_name + "]: "), format_(format), log_fd_(-1) {
     OpenLogFile(service_name);
+    if (mode == Mode::kAsync) {
+        async_ = std::make_unique<AsyncRing>();
+        async_->writer = std::thread([this]() { WriterLoop(); });
+    }
 }
 
 /**
  * @brief Opens the log file for the specified service name.
- *        The log file is created in /tmp/<service_name>.log format.
+ *        The log file is created in /tmp/<service_name>.log format,
+ *        or /tmp/<service_name>.binlog for binary logs.
  * @param service_name The name of the service used to create the log file.
  * @throws std::runtime_error if the log file cannot be opened.
  */
 void Logger::OpenLogFile(const std::string& service_name) {
-    log_file_path_ = "/tmp/" + service_name + ".log";
-    log_file_.open(log_file_path_, std::ios::app);
-    if (!log_file_.is_open()) {
+    log_file_path_ = "/tmp/" + service_name + (format_ == Format::kBinary ? ".binlog" : ".log");
+    log_fd_ = open(log_file_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd_ < 0) {
         throw std::runtime_error("Failed to open log file: " + log_file_path_);
     }
+
+    struct stat st;
+    if (format_ == Format::kBinary && fstat(log_fd_, &st) == 0 && st.st_size == 0) {
+        std::string header(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+        uint16_t name_length = static_cast<uint16_t>(service_name.size());
+        header.append(reinterpret_cast<const char *>(&name_length), sizeof(name_length));
+        header.append(service_name);
+        WriteAll(log_fd_, header.data(), header.size());
+    }
 }
 
 /**
  * @brief Logs a message to the log file.
  */
 void Logger::Log(const std::string &message) const {
-    if (log_file_.is_open()) {
-        log_file_ << "[" << service_name_ << "]: " << message << std::endl;
+    if (!async_ && format_ == Format::kText) {
+        WriteLine(message.data(), message.size());
+        return;
     }
+    LogArgs args;
+    args.Add(message);
+    LogRecord(LogId::kMessage, args);
 }
 
 /**
- * @brief Destructor closes the log file.
+ * @brief Encodes a structured message and queues or writes it.
+ */
+void Logger::LogRecord(LogId id, const LogArgs &args) const {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    char record[kLogRecordMaxSize];
+    std::size_t size = EncodeLogRecord(
+        id, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()), args, record);
+
+    if (async_) {
+        if (!async_->Push(record, size)) {
+            async_->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    std::string out;
+    AppendRecord(record, size, out);
+    WriteAll(log_fd_, out.data(), out.size());
+}
+
+/**
+ * @brief Appends an encoded record to out in the file format of the logger.
+ *
+ * Binary records are prefixed with their uint16 size, text records are
+ * formatted into a "[<service_name>]: message" line.
+ */
+void Logger::AppendRecord(const char *record, std::size_t size, std::string &out) const {
+    if (format_ == Format::kBinary) {
+        uint16_t length = static_cast<uint16_t>(size);
+        out.append(reinterpret_cast<const char *>(&length), sizeof(length)).append(record, size);
+        return;
+    }
+    out.append(prefix_);
+    FormatLogRecord(record, size, out);
+    out.push_back('\n');
+}
+
+/**
+ * @brief Writes one formatted line with a single write() call.
+ */
+void Logger::WriteLine(const char *message, std::size_t length) const {
+    std::string line;
+    line.reserve(prefix_.size() + length + 1);
+    line.append(prefix_).append(message, length).push_back('\n');
+    WriteAll(log_fd_, line.data(), line.size());
+}
+
+/**
+ * @brief Waits until every message logged before the call is written.
+ */
+void Logger::Flush() const {
+    if (!async_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(async_->mutex);
+    uint64_t target = async_->enqueue_pos.load(std::memory_order_seq_cst);
+    async_->flushed_cv.wait(lock, [this, target]() { return async_->written_pos >= target; });
+}
+
+/**
+ * @brief Number of messages dropped because the async ring was full.
+ */
+uint64_t Logger::dropped() const {
+    return async_ ? async_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+/**
+ * @brief Background thread of the async mode.
+ *
+ * Formats the records into one buffer and writes it when it is full or the
+ * ring runs empty, then sleeps until a producer signals new records.
+ */
+void Logger::WriterLoop() {
+    AsyncRing &ring = *async_;
+    std::string batch;
+    batch.reserve(kBatchBytes);
+    uint64_t pos = 0;
+
+    while (true) {
+        if (ring.Readable(pos)) {
+            AsyncRing::Slot &slot = ring.slots[pos & (kRingSlots - 1)];
+            AppendRecord(slot.data, slot.length, batch);
+            slot.sequence.store(pos + kRingSlots, std::memory_order_release);
+            ++pos;
+            if (batch.size() < kBatchBytes) {
+                continue;
+            }
+        }
+
+        if (!batch.empty()) {
+            WriteAll(log_fd_, batch.data(), batch.size());
+            batch.clear();
+            std::lock_guard<std::mutex> lock(ring.mutex);
+            ring.written_pos = pos;
+            ring.flushed_cv.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(ring.mutex);
+        ring.writer_sleeping.store(true, std::memory_order_seq_cst);
+        while (!ring.Readable(pos) && !ring.stopping) {
+            ring.work_cv.wait(lock);
+        }
+        ring.writer_sleeping.store(false, std::memory_order_relaxed);
+        if (!ring.Readable(pos) && ring.stopping) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Destructor writes the pending messages and closes the log file.
  */
 Logger::~Logger() {
-    if (log_file_.is_open()) {
-        log_file_.close();
+    if (async_) {
+        {
+            std::lock_guard<std::mutex> lock(async_->mutex);
+            async_->stopping = true;
+            async_->work_cv.notify_one();
+        }
+        async_->writer.join();
+        uint64_t dropped = async_->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            async_.reset(); // Write the summary synchronously
+            Log("Dropped " + std::to_string(dropped) + " log messages");
+        }
+    }
+    if (log_fd_ >= 0) {
+        close(log_fd_);
     }
 }
 
-} // namespace hello_ipc
\ No newline at end of file
+} // namespace hello_ipc
@@ -0,0 +1,106 @@
+#include "Metrics.hpp"
+
+#include <chrono>
+#include <unordered_map>
+
+namespace hello_ipc {
+
+namespace {
+
+std::atomic<uint64_t> next_metrics_id{1};
+
+} // namespace
+
+/**
+ * @brief Counters and histograms recorded by one thread.
+ *
+ * Counters are only written by the owning thread, so relaxed loads and stores
+ * are enough. The histograms are guarded by a mutex that only Read() contends on.
+ */
+struct Metrics::Shard {
+    alignas(64) std::array<std::atomic<uint64_t>, kCounterCount> counters{};
+    std::mutex mutex;
+    std::array<LatencyHistogram, kStageCount> stages;
+};
+
+Metrics::Metrics() : id_(next_metrics_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+Metrics::~Metrics() = default;
+
+/**
+ * @brief Adds delta to a counter. Negative deltas wrap and cancel out in Read().
+ */
+void Metrics::Add(Counter counter, int64_t delta) {
+    std::atomic<uint64_t> &value = LocalShard().counters[counter];
+    value.store(value.load(std::memory_order_relaxed) + static_cast<uint64_t>(delta), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Records the duration of one pass through a stage.
+ */
+void Metrics::RecordLatency(Stage stage, uint64_t nanoseconds) {
+    Shard &shard = LocalShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.stages[stage].Record(nanoseconds);
+}
+
+/**
+ * @brief Merges every shard into one snapshot.
+ */
+Metrics::Snapshot Metrics::Read() const {
+    Snapshot snapshot;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (const auto &shard : shards_) {
+        for (int i = 0; i < kCounterCount; ++i) {
+            snapshot.counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> shard_lock(shard->mutex);
+        for (int i = 0; i < kStageCount; ++i) {
+            snapshot.stages[i].Merge(shard->stages[i]);
+        }
+    }
+    return snapshot;
+}
+
+const char *Metrics::StageName(Stage stage) {
+    switch (stage) {
+        case kRecv: return "recv";
+        case kParse: return "parse";
+        case kHandle: return "handle";
+        case kSerialize: return "serialize";
+        case kSend: return "send";
+        default: return "unknown";
+    }
+}
+
+uint64_t Metrics::Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Returns the calling thread's shard, creating it on first use.
+ */
+Metrics::Shard &Metrics::LocalShard() {
+    struct CachedShard {
+        uint64_t owner_id = 0;
+        Shard *shard = nullptr;
+    };
+    static thread_local CachedShard last;
+    static thread_local std::unordered_map<uint64_t, Shard *> shards;
+
+    if (last.owner_id == id_) {
+        return *last.shard;
+    }
+
+    Shard *&shard = shards[id_];
+    if (!shard) {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        shards_.push_back(std::make_unique<Shard>());
+        shard = shards_.back().get();
+    }
+    last = {id_, shard};
+    return *shard;
+}
+
+} // namespace hello_ipc
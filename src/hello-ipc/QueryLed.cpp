@@ -2,11 +2,60 @@
 #include "led_service.pb.h"
 
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <iomanip>
 
 namespace hello_ipc {
 
+namespace {
+
+bool ParseLedName(const std::string &led_name, uint32_t *led_id) {
+    const char *last = led_name.data() + led_name.size();
+    auto result = std::from_chars(led_name.data(), last, *led_id);
+    return !led_name.empty() && result.ec == std::errc() && result.ptr == last;
+}
+
+/**
+ * @brief Identifies the LED of a request by numeric id, falling back to led_num.
+ *
+ * Names that are not a number fitting led_id are sent as led_num so the server
+ * reports the error.
+ */
+template <typename LedRequest>
+void SetLedId(LedRequest *req, const std::string &led_name) {
+    uint32_t led_id;
+    if (ParseLedName(led_name, &led_id)) {
+        req->set_led_id(led_id);
+    } else {
+        req->set_led_num(led_name);
+    }
+}
+
+std::string LedName(const hello_ipc::LedStateResponse &state_res) {
+    return state_res.has_led_id() ? std::to_string(state_res.led_id()) : state_res.led_num();
+}
+
+/**
+ * @brief Logs the outcome of a state response without formatting the whole message.
+ */
+void LogStateResponse(const Logger &logger, const hello_ipc::Response &res) {
+    const auto &state_res = res.state_response();
+    std::string_view outcome = state_res.error_message();
+    if (outcome.empty()) {
+        outcome = (state_res.state() == hello_ipc::LedState::ON) ? "on" : "off";
+    }
+    if (state_res.has_led_id()) {
+        logger.Log(LogId::kStateResponseReceived, res.request_id(), state_res.led_id(), outcome);
+    } else {
+        logger.Log(LogId::kStateResponseReceived, res.request_id(), state_res.led_num(), outcome);
+    }
+}
+
+} // namespace
+
 /**
  * @brief Constructs a QueryLed client.
  * 
@@ -17,7 +66,7 @@ namespace hello_ipc {
  * @throws std::runtime_error If the socket connection fails.
  */
 QueryLed::QueryLed(const std::string &socket_path, bool connect)
-        : Service("QueryLed", connect) {
+        : Service("QueryLed", connect), next_request_id_(1) {
     if (connect) {
         ConnectToServer(socket_path);
     }
@@ -71,7 +120,8 @@ void QueryLed::HandleUserInput(std::istream &input_stream) {
 void QueryLed::queryState(const std::string &led_name) {
     hello_ipc::Request req;
     auto* query_req = req.mutable_query_request();
-    query_req->set_led_num(led_name);
+    SetLedId(query_req, led_name);
+    req.set_request_id(next_request_id_++);
 
     std::string message;
     if (!req.SerializeToString(&message)) {
@@ -80,7 +130,7 @@ void QueryLed::queryState(const std::string &led_name) {
     }
 
     SendMessage(message);
-    logger().Log("Sent query for LED " + led_name);
+    logger().Log(LogId::kQuerySent, led_name);
 
     auto response_opt = ReceiveMessage();
     if (!response_opt) {
@@ -93,6 +143,9 @@ void QueryLed::queryState(const std::string &led_name) {
         std::cerr << "Error: Failed to parse response." << std::endl;
         return;
     }
+    if (res.request_id() != 0 && res.request_id() != req.request_id()) {
+        logger().Log("Response id " + std::to_string(res.request_id()) + " does not match the query.");
+    }
 
     if (res.has_state_response()) {
         const auto& state_res = res.state_response();
@@ -100,10 +153,130 @@ void QueryLed::queryState(const std::string &led_name) {
             std::cout << "Error from server: " << state_res.error_message() << std::endl;
         } else {
             std::string state = (state_res.state() == hello_ipc::LedState::ON) ? "on" : "off";
-            std::cout << "Response: Led" << state_res.led_num() << "=" << state << std::endl;
+            std::cout << "Response: Led" << LedName(state_res) << "=" << state << std::endl;
+        }
+    }
+    LogStateResponse(logger(), res);
+}
+
+/**
+ * @brief Fetches the server's runtime metrics and prints them.
+ *
+ * @param out Stream the metrics are printed to.
+ * @return false if the server did not answer with metrics.
+ */
+bool QueryLed::QueryStats(std::ostream &out) {
+    hello_ipc::Request req;
+    req.mutable_stats_request();
+    req.set_request_id(next_request_id_++);
+
+    std::string message;
+    if (!req.SerializeToString(&message)) {
+        std::cerr << "Error: Failed to serialize request." << std::endl;
+        return false;
+    }
+    SendMessage(message);
+
+    auto response_opt = ReceiveMessage();
+    if (!response_opt) {
+        std::cerr << "Error: Failed to receive response from server." << std::endl;
+        return false;
+    }
+
+    hello_ipc::Response res;
+    if (!res.ParseFromString(*response_opt) || !res.has_stats_response()) {
+        std::cerr << "Error: Failed to parse response." << std::endl;
+        return false;
+    }
+
+    const auto &stats = res.stats_response();
+    out << "Requests:       update " << stats.update_requests() << ", query " << stats.query_requests()
+        << ", batch update " << stats.batch_update_requests() << ", batch query " << stats.batch_query_requests()
+        << ", stats " << stats.stats_requests() << ", subscribe " << stats.subscribe_requests()
+        << ", compare-and-set " << stats.compare_and_set_requests() << "\n"
+        << "No-op updates:  " << stats.noop_updates() << " not written\n"
+        << "Notifications:  " << stats.notifications_sent() << " sent\n"
+        << "Parse failures: " << stats.parse_failures() << "\n"
+        << "Bytes:          in " << stats.bytes_in() << ", out " << stats.bytes_out() << "\n"
+        << "Connections:    " << stats.active_connections() << " active, "
+        << stats.rejected_connections() << " rejected at the limit\n"
+        << "Overloaded:     " << stats.overloaded_requests() << " requests over the in-flight limit\n"
+        << "Client queues: ";
+    for (const auto &queue : stats.client_queues()) {
+        out << " " << queue.client_id() << ":" << queue.depth();
+    }
+    out << " (client:depth)\n"
+        << std::left << std::setw(12) << "Stage" << std::right << std::setw(12) << "count"
+        << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us"
+        << std::setw(12) << "max us" << "\n";
+
+    out << std::fixed << std::setprecision(1);
+    for (const auto &stage : stats.stages()) {
+        out << std::left << std::setw(12) << stage.stage() << std::right << std::setw(12) << stage.count()
+            << std::setw(12) << stage.p50_ns() / 1000.0 << std::setw(12) << stage.p99_ns() / 1000.0
+            << std::setw(12) << stage.p999_ns() / 1000.0 << std::setw(12) << stage.max_ns() / 1000.0 << "\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Subscribes to LED changes and prints them as they are pushed by the server.
+ *
+ * Waits without a timeout, so a quiet server does not end the watch.
+ *
+ * @param led_nums The LEDs to watch; every LED if empty.
+ * @param out Stream the changes are printed to.
+ * @param max_changes Number of changes to print before returning, 0 for no limit.
+ * @return false if the subscription was refused or the connection failed.
+ */
+bool QueryLed::Watch(const std::vector<std::string> &led_nums, std::ostream &out, int max_changes) {
+    hello_ipc::Request req;
+    auto *subscribe_req = req.mutable_subscribe_request();
+    for (const auto &led_num : led_nums) {
+        uint32_t led_id;
+        if (ParseLedName(led_num, &led_id)) {
+            subscribe_req->add_led_ids(led_id);
+        } else {
+            subscribe_req->add_led_nums(led_num); // Rejected by the server with its own message
+        }
+    }
+    req.set_request_id(next_request_id_++);
+
+    std::string message;
+    if (!req.SerializeToString(&message)) {
+        std::cerr << "Error: Failed to serialize request." << std::endl;
+        return false;
+    }
+    SetReceiveTimeout(0);
+    SendMessage(message);
+
+    for (int changes = 0; max_changes == 0 || changes < max_changes;) {
+        auto response_opt = ReceiveMessage();
+        if (!response_opt) {
+            std::cerr << "Error: Failed to receive response from server." << std::endl;
+            return false;
+        }
+
+        hello_ipc::Response res;
+        if (!res.ParseFromString(*response_opt) || res.request_id() != req.request_id()) {
+            std::cerr << "Error: Failed to parse response." << std::endl;
+            return false;
+        }
+        if (res.has_subscribe_response()) {
+            if (!res.subscribe_response().error_message().empty()) {
+                std::cerr << "Error from server: " << res.subscribe_response().error_message() << std::endl;
+                return false;
+            }
+            continue;
+        }
+        if (res.has_state_response()) {
+            const auto &state_res = res.state_response();
+            out << "Led" << LedName(state_res) << "="
+                << ((state_res.state() == hello_ipc::LedState::ON) ? "on" : "off") << std::endl;
+            ++changes;
         }
     }
-    logger().Log("Received response: " + res.DebugString());
+    return true;
 }
 
-} // namespace hello_ipc
\ No newline at end of file
+} // namespace hello_ipc
@@ -0,0 +1,79 @@
+#include "ReceiveBuffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+namespace hello_ipc {
+
+namespace {
+
+/**
+ * @brief Checks whether the buffer holds the only reference to a block.
+ *
+ * Pins are only created by the buffer's own thread, so a count of one cannot grow
+ * behind our back. The fence orders the other holders' last reads of the block
+ * before the buffer writes to it again.
+ */
+bool IsUnshared(const std::shared_ptr<char[]> &block) {
+    if (block.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Creates an empty buffer.
+ *
+ * @param block_size Size of the blocks, larger blocks are only used for larger reservations.
+ */
+ReceiveBuffer::ReceiveBuffer(std::size_t block_size)
+    : block_size_(block_size), block_(new char[block_size]), spare_capacity_(0),
+      capacity_(block_size), begin_(0), end_(0) {}
+
+/**
+ * @brief Makes sure at least min_free bytes can be written after the unread data.
+ *
+ * @param min_free Number of bytes the caller wants to write.
+ * @return Start of the free space, valid for writable() bytes.
+ */
+char *ReceiveBuffer::Reserve(std::size_t min_free) {
+    if (capacity_ - end_ >= min_free) {
+        return block_.get() + end_;
+    }
+
+    std::size_t pending = end_ - begin_;
+    std::size_t needed = pending + min_free;
+    if (capacity_ >= needed && IsUnshared(block_)) {
+        // Nobody reads the consumed bytes anymore, move the tail to the front in place
+        memmove(block_.get(), block_.get() + begin_, pending);
+    } else {
+        if (!spare_ || spare_capacity_ < needed || !IsUnshared(spare_)) {
+            spare_capacity_ = std::max(block_size_, needed);
+            spare_.reset(new char[spare_capacity_]);
+        }
+        memcpy(spare_.get(), block_.get() + begin_, pending);
+        std::swap(block_, spare_);
+        std::swap(capacity_, spare_capacity_);
+    }
+    begin_ = 0;
+    end_ = pending;
+    return block_.get() + end_;
+}
+
+/**
+ * @brief Appends a copy of data to the unread bytes.
+ *
+ * @param data The bytes to append.
+ * @param count Number of bytes.
+ */
+void ReceiveBuffer::Append(const char *data, std::size_t count) {
+    memcpy(Reserve(count), data, count);
+    Commit(count);
+}
+
+} // namespace hello_ipc
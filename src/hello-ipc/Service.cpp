@@ -1,19 +1,182 @@
 #include "Service.hpp"
+#include "IoUring.hpp"
+#include "ShmChannel.hpp"
+#include "WorkerPool.hpp"
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <deque>
 #include <stdexcept>
 #include <cstring>
 #include <iostream>
 #include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <arpa/inet.h>
 
 namespace hello_ipc {
 
 const int kMaxMessageSize = 4096;
+const int kMaxEpollEvents = 64;
+const std::size_t kReadChunkSize = 16384;
+const std::size_t kMinReadSpace = 4096;
+const std::size_t kMaxCorkedBytes = 64 * 1024;
+const std::size_t kMaxUnsentBytes = 1024 * 1024; // A client further behind is disconnected
+const int kShmTimeoutMs = 5000;
+
+// First byte a client sends after connecting. Legacy clients start right away with
+// a length prefix, whose first byte is always 0 because messages are small.
+const unsigned char kHandshakeSharedMemory = 'S';
+const unsigned char kHandshakeCompact = 'C'; // Precedes any other handshake byte
+const unsigned char kHandshakeAccepted = 1;
+
+/**
+ * @brief Server side state of one accepted client in one worker lane.
+ */
+struct Service::LaneState {
+    std::atomic<int> queued{0}; // Messages dispatched to the lane but not handled yet
+    std::string outbox; // Only touched by the lane's worker serving the connection
+};
+
+/**
+ * @brief Server side state of one accepted client.
+ *
+ * The socket is closed when the last reference goes away, so a worker that is
+ * still answering a message never writes to a reused descriptor.
+ */
+struct Service::Connection : std::enable_shared_from_this<Connection> {
+    explicit Connection(int client_fd) : fd(client_fd), buffer(kReadChunkSize) {}
+    ~Connection() { close(fd); }
+
+    const int fd;
+    ReceiveBuffer buffer; // Bytes received but not yet framed, pinned by the workers
+
+    // Socket responses are corked while more messages of the client wait for its worker
+    // in the same lane, then leave in a single sendmsg
+    LaneState lanes[kLaneCount];
+    std::atomic<int> in_flight{0}; // Messages of both lanes admitted to the message handler
+    bool handshake_done = false; // Set once the transport of the client is known
+    bool compact = false; // The client uses the CompactMessage encoding
+    bool closing = false; // Set once the client sent an invalid frame
+
+    // Shared memory transport: frames travel through the rings instead of the socket
+    std::unique_ptr<ShmChannel> shm;
+
+    // Serializes writers: the worker, the event loop and, for pushed messages, other server threads.
+    // epoll backend: also guards the bytes the client did not take yet, sent once the socket
+    // is writable again. io_uring backend: also guards the responses waiting for the linked
+    // send in flight
+    std::mutex send_mutex;
+    std::string unsent;
+    std::deque<std::pair<uint32_t, std::string>> send_queue;
+    std::size_t send_queue_bytes = 0;
+    std::shared_ptr<Connection> send_keepalive; // Set while a send references this connection
+};
+
+namespace {
+
+enum class FrameStatus { kComplete, kIncomplete, kInvalid };
+
+/**
+ * @brief Looks for one frame at the start of data.
+ *
+ * Frames are a 4-byte network order length followed by the message body.
+ *
+ * @param data Received bytes, starting at a frame boundary.
+ * @param body Set to the message body if the frame is complete.
+ * @param msg_size Set to the body length once the length prefix is available.
+ * @return Whether a complete frame was found, or the length prefix is invalid.
+ */
+FrameStatus NextFrame(std::string_view data, std::string_view *body, uint32_t *msg_size) {
+    if (data.size() < sizeof(uint32_t)) {
+        return FrameStatus::kIncomplete;
+    }
+    memcpy(msg_size, data.data(), sizeof(*msg_size));
+    *msg_size = ntohl(*msg_size); // Convert from network to host byte order
+    if (*msg_size == 0 || *msg_size > kMaxMessageSize) { // Basic sanity check
+        return FrameStatus::kInvalid;
+    }
+    if (data.size() - sizeof(uint32_t) < *msg_size) {
+        return FrameStatus::kIncomplete; // Wait for the rest of the message body
+    }
+    *body = data.substr(sizeof(uint32_t), *msg_size);
+    return FrameStatus::kComplete;
+}
+
+/**
+ * @brief Writes the bytes described by iov, resuming after partial writes.
+ *
+ * @param fd The socket to write to.
+ * @param iov The buffers to send; advanced past the bytes written.
+ * @param iovcnt Number of buffers; reduced to the ones not written completely.
+ * @param flags MSG_DONTWAIT returns once the socket is full instead of waiting.
+ * @return false if the socket failed, with errno set.
+ */
+bool WriteIov(int fd, struct iovec **iov, std::size_t *iovcnt, int flags) {
+    while (*iovcnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = *iov;
+        msg.msg_iovlen = std::min<std::size_t>(*iovcnt, IOV_MAX);
+
+        ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL | flags);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return (flags & MSG_DONTWAIT) && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        std::size_t left = static_cast<std::size_t>(written);
+        while (*iovcnt > 0 && left >= (*iov)->iov_len) {
+            left -= (*iov)->iov_len;
+            ++*iov;
+            --*iovcnt;
+        }
+        if (*iovcnt > 0) {
+            (*iov)->iov_base = static_cast<char *>((*iov)->iov_base) + left;
+            (*iov)->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes every byte described by iov, waiting while the socket is full.
+ *
+ * @param fd The socket to write to.
+ * @param iov The buffers to send; modified while the write progresses.
+ * @param iovcnt Number of buffers.
+ * @return false if the socket failed, with errno set.
+ */
+bool WriteFully(int fd, struct iovec *iov, std::size_t iovcnt) {
+    return WriteIov(fd, &iov, &iovcnt, 0);
+}
+
+void SetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+// HELLO_IPC_LOG_FORMAT=binary switches every service to the binary log format.
+Logger::Format LogFormatFromEnvironment() {
+    const char *format = std::getenv("HELLO_IPC_LOG_FORMAT");
+    return (format && std::string(format) == "binary") ? Logger::Format::kBinary : Logger::Format::kText;
+}
+
+} // namespace
+
+thread_local Service::Connection *Service::current_connection_ = nullptr;
+thread_local Service::Lane Service::current_lane_ = Service::Lane::kBulk;
 
 /** 
  * @brief Constructs a Service with the given service name.
@@ -21,9 +184,13 @@ const int kMaxMessageSize = 4096;
  * Initializes the logger and sets the socket file descriptor to -1 (not connected).
  *
  * @param service_name The name of the service for logging purposes.
+ * @param log_mode Whether log messages are written by the caller or by a background thread.
  */
-Service::Service(const std::string &service_name, bool connect)
-            : logger_(service_name), sockfd_(-1) {
+Service::Service(const std::string &service_name, bool connect, Logger::Mode log_mode)
+            : logger_(service_name, log_mode, LogFormatFromEnvironment()), sockfd_(-1),
+              receive_timeout_ms_(kShmTimeoutMs), wire_format_(WireFormat::kProtobuf), wake_fd_(-1),
+              stop_requested_(false), server_backend_(ServerBackend::kEpoll),
+              uring_(nullptr), uring_users_(0), uring_sends_in_flight_(0) {
     (void)connect; // Suppress unused parameter warning
 }
 
@@ -39,9 +206,13 @@ Service::~Service() {
 /** 
  * @brief Connects to a server at the specified socket path.
  *
+ * Setting the HELLO_IPC_TRANSPORT environment variable to "shm" makes the client
+ * exchange its frames through shared memory rings instead of the socket.
+ *
  * @param socket_path The path to the socket file.
  * @return true if connection is successful, false otherwise.
  */
+
 bool Service::ConnectToServer(const std::string &socket_path) {
     sockfd_ = socket(AF_UNIX, SOCK_STREAM, 0);
     if (sockfd_ < 0) {
@@ -60,68 +231,1022 @@ bool Service::ConnectToServer(const std::string &socket_path) {
         sockfd_ = -1;
         return false;
     }
+    SetupSocketTimeout(sockfd_);
+
+    if (wire_format_ == WireFormat::kCompact && !RequestCompactFormat()) {
+        close(sockfd_);
+        sockfd_ = -1;
+        return false;
+    }
+
+    const char *transport = std::getenv("HELLO_IPC_TRANSPORT");
+    if (transport && std::string(transport) == "shm" && !SetupSharedMemory()) {
+        close(sockfd_);
+        sockfd_ = -1;
+        return false;
+    }
 
     logger().Log("Connection established to " + socket_path);
     return true;
 }
 
 /** 
- * @brief Runs a multi-threaded server loop that listens for incoming connections.
+ * @brief Asks the server to use the CompactMessage encoding on this connection.
+ *
+ * @return true if the server accepted.
+ */
+bool Service::RequestCompactFormat() {
+    unsigned char request = kHandshakeCompact;
+    unsigned char reply = 0;
+    if (send(sockfd_, &request, sizeof(request), MSG_NOSIGNAL) != 1 ||
+        recv(sockfd_, &reply, sizeof(reply), MSG_WAITALL) != 1 || reply != kHandshakeAccepted) {
+        logger().Log("Server refused the compact wire format.");
+        return false;
+    }
+    return true;
+}
+
+/** 
+ * @brief Switches the connected client to the shared memory transport.
+ *
+ * Creates the rings and passes the memfd and both eventfds to the server with
+ * SCM_RIGHTS, then waits for the server to accept them.
+ *
+ * @return true if the server accepted the channel.
+ */
+bool Service::SetupSharedMemory() {
+    try {
+        shm_ = ShmChannel::Create();
+    } catch (const std::runtime_error &e) {
+        logger().Log(e.what());
+        return false;
+    }
+
+    int fds[3] = {shm_->memfd(), shm_->event_fd(ShmChannel::kRequest), shm_->event_fd(ShmChannel::kResponse)};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    unsigned char handshake = kHandshakeSharedMemory;
+    struct iovec iov = {&handshake, sizeof(handshake)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    unsigned char reply = 0;
+    if (sendmsg(sockfd_, &msg, MSG_NOSIGNAL) != 1 ||
+        recv(sockfd_, &reply, sizeof(reply), MSG_WAITALL) != 1 || reply != kHandshakeAccepted) {
+        logger().Log("Server refused the shared memory transport.");
+        shm_.reset();
+        return false;
+    }
+
+    logger().Log("Using the shared memory transport.");
+    return true;
+}
+
+/** 
+ * @brief Runs the server event loop that listens for incoming connections.
+ *
+ * A single thread multiplexes the listening socket and every client socket, using
+ * either epoll or io_uring (see SetServerBackend()). Complete frames are handed to
+ * a fixed-size worker pool; messages of the same client always go to the same
+ * worker so they are handled in order. The loop returns once StopServer() is called.
  *
  * @param socket_path The path to the socket file.
  * @param message_handler A function to handle incoming messages from clients.
  */
 void Service::RunServer(const std::string &socket_path,
-                        const std::function<void(int, const std::string&)> &message_handler) {
+                        const std::function<void(int, std::string_view)> &message_handler) {
 
     int server_fd = CreateServerSocket(socket_path);
+    if (server_fd < 0) {
+        return;
+    }
+
+    int wake_fd = eventfd(0, EFD_CLOEXEC); // Blocking, so an io_uring read waits for the signal
+    if (wake_fd < 0) {
+        logger().Log("Failed to create event loop: " + std::string(strerror(errno)));
+        close(server_fd);
+        return;
+    }
+    wake_fd_ = wake_fd;
+    if (stop_requested_) {
+        StopServer(); // Stopped before the loop could be woken up
+    }
+
     logger().Log("Server listening on socket: " + socket_path);
 
+    bool served = false;
+    if (server_backend_ == ServerBackend::kIoUring) {
+        served = RunIoUringLoop(server_fd, wake_fd, message_handler);
+        if (!served) {
+            logger().Log("io_uring backend unavailable, falling back to epoll.");
+        }
+    }
+    if (!served) {
+        RunEpollLoop(server_fd, wake_fd, message_handler);
+    }
+
+    wake_fd_ = -1;
+    stop_requested_ = false;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.clear();
+        client_count_ = 0;
+    }
+    close(wake_fd);
+    close(server_fd);
+    unlink(socket_path.c_str());
+    logger().Log("Server stopped.");
+}
+
+/** 
+ * @brief Makes a running RunServer loop return.
+ *
+ * Safe to call from any thread, including message handlers and signal handlers.
+ * The request is latched, so a stop that arrives while RunServer is still setting
+ * up makes the loop return as soon as it starts.
+ */
+void Service::StopServer() {
+    stop_requested_ = true;
+    int wake_fd = wake_fd_;
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd, &one, sizeof(one));
+        (void)written; // The counter can only overflow if the loop is already stopping
+    }
+}
+
+/** 
+ * @brief Serves clients with an edge-triggered epoll readiness loop.
+ *
+ * @param server_fd The listening socket.
+ * @param wake_fd Eventfd signalled by StopServer().
+ * @param message_handler A function to handle incoming messages from clients.
+ */
+void Service::RunEpollLoop(int server_fd, int wake_fd, const MessageHandler &message_handler) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        logger().Log("Failed to create epoll instance: " + std::string(strerror(errno)));
+        return;
+    }
+    SetNonBlocking(server_fd);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = server_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+    // The pools are drained before the loop returns and the connections are dropped
+    WorkerPool workers[kLaneCount];
+
+    std::vector<struct epoll_event> events(kMaxEpollEvents);
+    bool running = true;
+    while (running) {
+        int n = epoll_wait(epoll_fd, events.data(), kMaxEpollEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            logger().Log("epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == wake_fd) {
+                running = false;
+            } else if (fd == server_fd) {
+                AcceptClients(server_fd, epoll_fd);
+            } else {
+                std::shared_ptr<Connection> conn = FindConnection(fd);
+                if (!conn) continue;
+                if (events[i].events & EPOLLOUT) {
+                    FlushUnsent(*conn);
+                }
+                if (!(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                    continue; // Only became writable
+                }
+
+                auto dispatch = [&](std::string_view message) {
+                    Dispatch(workers, conn, message, message_handler);
+                };
+
+                bool open = true;
+                if (fd != conn->fd) {
+                    // The request ring eventfd of a shared memory client, also signalled once
+                    // the client made room in a response ring that was full
+                    conn->shm->ClearSignal(ShmChannel::kRequest);
+                    FlushUnsent(*conn);
+                    open = ReadSharedMemoryFrames(*conn, dispatch);
+                } else {
+                    if (!conn->handshake_done) {
+                        open = ReadHandshake(*conn) && (!conn->shm || WatchSharedMemory(epoll_fd, conn));
+                    }
+                    open = open && ReadFrames(*conn, dispatch);
+                }
+                if (!open) {
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+                    RemoveConnection(conn->fd);
+                }
+            }
+        }
+    }
+
+    close(epoll_fd);
+}
+
+/** 
+ * @brief Hands a complete message to the worker serving the connection in its lane.
+ *
+ * ClassifyMessage() picks the lane. Every lane has its own pool, so interactive
+ * messages of one client never wait behind bulk messages of another. The messages of
+ * a client are handled in arrival order: while the client has messages queued in one
+ * lane, its later messages follow them into that lane whatever their class, so a
+ * query never overtakes the client's own update.
+ *
+ * The message is not copied: the task pins the receive block it points into.
+ * Responses are flushed before the last queued message of the client in the lane
+ * counts as handled, so they also leave before those of the next lane. A message arriving while the client already has max_in_flight messages
+ * queued is answered right away with OverloadedResponse() and never queued, so a
+ * flooding client cannot grow the queues or keep receive blocks pinned; its answers
+ * may overtake the responses to its queued messages.
+ *
+ * @param workers The worker pools, one per lane.
+ * @param conn The connection the message arrived on.
+ * @param message The message body, a view into the connection's receive buffer.
+ * @param message_handler The server's message handler.
+ */
+void Service::Dispatch(WorkerPool *workers, const std::shared_ptr<Connection> &conn, std::string_view message,
+                       const MessageHandler &message_handler) {
+    WireFormat wire_format = conn->compact ? WireFormat::kCompact : WireFormat::kProtobuf;
+    if (limits_.max_in_flight > 0 && conn->in_flight.load(std::memory_order_relaxed) >= limits_.max_in_flight) {
+        metrics_.Add(Metrics::kOverloadedRequests);
+        std::optional<std::string> response = OverloadedResponse(message, wire_format);
+        if (response) {
+            SendResponse(conn->fd, *response); // Never waits for the client
+        }
+        return;
+    }
+
+    Lane lane = ClassifyMessage(message, wire_format);
+    Lane other = lane == Lane::kBulk ? Lane::kInteractive : Lane::kBulk;
+    if (conn->lanes[static_cast<std::size_t>(other)].queued.load(std::memory_order_acquire) > 0) {
+        lane = other; // Pinned to the lane that still has work of this client
+    }
+    conn->in_flight.fetch_add(1, std::memory_order_relaxed);
+    LaneState &state = conn->lanes[static_cast<std::size_t>(lane)];
+    state.queued.fetch_add(1, std::memory_order_relaxed);
+    workers[static_cast<std::size_t>(lane)].Submit(static_cast<std::size_t>(conn->fd),
+        [this, conn, &state, &message_handler, block = conn->buffer.Pin(), message, lane]() {
+            current_connection_ = conn.get();
+            current_lane_ = lane;
+            message_handler(conn->fd, message);
+            conn->in_flight.fetch_sub(1, std::memory_order_relaxed);
+            current_connection_ = nullptr;
+            if (state.queued.load(std::memory_order_relaxed) == 1) {
+                FlushResponses(*conn, state);
+            }
+            state.queued.fetch_sub(1, std::memory_order_release);
+        });
+}
+
+/** 
+ * @brief Accepts every pending connection on the listening socket.
+ *
+ * Called when the edge-triggered listening socket becomes readable.
+ *
+ * @param server_fd The non-blocking listening socket.
+ * @param epoll_fd The epoll instance the new clients are registered with.
+ */
+void Service::AcceptClients(int server_fd, int epoll_fd) {
     while (true) {
-        int client_socket = accept(server_fd, NULL, NULL);
+        int client_socket = accept4(server_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
         if (client_socket < 0) {
-            perror("accept");
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept");
+            }
+            return;
+        }
+        if (!AdmitConnection(client_socket)) {
             continue;
         }
 
-        logger().Log("Accepted new connection.");
-        std::cout << "New client connected. ID= " << client_socket << std::endl;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET; // EPOLLOUT flushes unsent responses
+        ev.data.fd = client_socket;
+        AddConnection(client_socket);
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+            logger().Log("Failed to watch client socket: " + std::string(strerror(errno)));
+            RemoveConnection(client_socket);
+        }
+    }
+}
 
-        // Spawn a new thread to handle the client
-        std::thread([this, client_socket, handler = std::move(message_handler)]() {
-            while (true) {
-                uint32_t msg_size;
-                // Read the 4-byte size prefix
-                ssize_t received = recv(client_socket, &msg_size, sizeof(msg_size), MSG_WAITALL);
-                if (received <= 0) {
-                    break; // Client disconnected or error
-                }
+/** 
+ * @brief Enforces max_connections on a freshly accepted client.
+ *
+ * A client over the limit is closed right away, so it sees end-of-file instead of
+ * waiting in the backlog, and can back off and retry.
+ *
+ * @param client_socket The accepted socket, closed if false is returned.
+ * @return true if the client may be served.
+ */
+bool Service::AdmitConnection(int client_socket) {
+    if (limits_.max_connections > 0) {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        if (client_count_ >= limits_.max_connections) {
+            metrics_.Add(Metrics::kRejectedConnections);
+            logger().Log("Rejected connection: the server is at its connection limit.");
+            close(client_socket);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** 
+ * @brief Registers a freshly accepted client.
+ *
+ * @param client_socket The accepted socket; owned by the returned connection.
+ * @return The new connection.
+ */
+std::shared_ptr<Service::Connection> Service::AddConnection(int client_socket) {
+    auto conn = std::make_shared<Connection>(client_socket);
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_[client_socket] = conn;
+        ++client_count_;
+    }
+    metrics_.Add(Metrics::kActiveConnections);
+    logger().Log("Accepted new connection.");
+    std::cout << "New client connected. ID= " << client_socket << std::endl;
+    return conn;
+}
+
+/** 
+ * @brief Looks up an open connection by its socket.
+ *
+ * @param client_socket The client socket.
+ * @return The connection, or nullptr if the client already disconnected.
+ */
+std::shared_ptr<Service::Connection> Service::FindConnection(int client_socket) const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = connections_.find(client_socket);
+    return it == connections_.end() ? nullptr : it->second;
+}
 
-                msg_size = ntohl(msg_size); // Convert from network to host byte order
-                if (msg_size == 0 || msg_size > kMaxMessageSize) { // Basic sanity check
-                    logger().Log("Invalid message size received: " + std::to_string(msg_size));
-                    break;
+/** 
+ * @brief Forgets a disconnected client.
+ *
+ * The socket is closed once the workers and pins drop their references to the
+ * connection, so OnClientDisconnected() runs before the descriptor can be reused.
+ *
+ * @param client_socket The client socket.
+ */
+void Service::RemoveConnection(int client_socket) {
+    std::shared_ptr<Connection> conn;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        auto it = connections_.find(client_socket);
+        if (it == connections_.end()) {
+            return;
+        }
+        conn = std::move(it->second);
+        connections_.erase(it);
+        --client_count_;
+        if (conn->shm) {
+            connections_.erase(conn->shm->event_fd(ShmChannel::kRequest));
+        }
+    }
+    metrics_.Add(Metrics::kActiveConnections, -1);
+    OnClientDisconnected(client_socket);
+    logger().Log("Client disconnected.");
+    std::cout << "Client disconnected. ID: " << client_socket << std::endl;
+}
+
+/** 
+ * @brief Tells a message handler how the message it is handling is encoded.
+ *
+ * @return true if the client negotiated the CompactMessage encoding. Only valid
+ * on a worker thread while it runs the message handler.
+ */
+bool Service::ClientUsesCompactFormat() const {
+    return current_connection_ && current_connection_->compact;
+}
+
+/** 
+ * @brief Reports how far each connected client is behind.
+ *
+ * @return The client socket and the number of its messages dispatched to a worker
+ * but not handled yet, including the one being handled, for every client.
+ */
+std::vector<std::pair<int, int>> Service::ClientQueueDepths() const {
+    std::vector<std::pair<int, int>> depths;
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    depths.reserve(connections_.size());
+    for (const auto &entry : connections_) {
+        if (entry.first == entry.second->fd) { // Skip the eventfds of shared memory clients
+            int depth = 0;
+            for (const auto &lane : entry.second->lanes) {
+                depth += lane.queued.load(std::memory_order_relaxed);
+            }
+            depths.emplace_back(entry.first, depth);
+        }
+    }
+    std::sort(depths.begin(), depths.end());
+    return depths;
+}
+
+/** 
+ * @brief Reports how far a client is behind in reading its responses.
+ *
+ * Lets server threads that push messages hold back instead of piling them up
+ * for a client that does not read.
+ *
+ * @param client_socket The client socket.
+ * @return Bytes buffered for the client, 0 if it is not connected.
+ */
+std::size_t Service::UnsentBytes(int client_socket) const {
+    std::shared_ptr<Connection> conn = FindConnection(client_socket);
+    if (!conn) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(conn->send_mutex);
+    return conn->unsent.size() + conn->send_queue_bytes;
+}
+
+/** 
+ * @brief Keeps a client's socket open while the returned handle lives.
+ *
+ * Lets other server threads push messages to a client without racing with a new
+ * client that would otherwise get the same descriptor after a disconnect.
+ *
+ * @param client_socket The client socket.
+ * @return The handle, or nullptr if no such client is connected.
+ */
+std::shared_ptr<const void> Service::PinConnection(int client_socket) const {
+    return FindConnection(client_socket);
+}
+
+/** 
+ * @brief Reads the first byte of a new connection, which selects its transport.
+ *
+ * A 0 byte is the start of a regular length prefix. kHandshakeSharedMemory comes
+ * with the client's memfd and eventfds attached as SCM_RIGHTS.
+ *
+ * @param conn The connection that has not finished its handshake yet.
+ * @return false if the client disconnected or sent an invalid handshake.
+ */
+bool Service::ReadHandshake(Connection &conn) const {
+    int fds[3] = {-1, -1, -1};
+    char control[CMSG_SPACE(sizeof(fds))];
+    unsigned char first = 0;
+    int fd_count = 0;
+
+    while (true) {
+        struct iovec iov = {&first, sizeof(first)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t received = recvmsg(conn.fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return true; // Nothing to read yet
+        }
+        if (received <= 0) {
+            return false;
+        }
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                fd_count = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+                memcpy(fds, CMSG_DATA(cmsg), std::min<std::size_t>(fd_count, 3) * sizeof(int));
+            }
+        }
+        if (first != kHandshakeCompact || fd_count != 0 || conn.compact) {
+            break;
+        }
+
+        // The encoding is chosen first, the transport byte follows once the client got the reply
+        conn.compact = true;
+        unsigned char accepted = kHandshakeAccepted;
+        if (send(conn.fd, &accepted, sizeof(accepted), MSG_NOSIGNAL) != 1) {
+            return false;
+        }
+    }
+    conn.handshake_done = true;
+
+    if (first == 0 && fd_count == 0) {
+        conn.buffer.Append("", 1); // The 0 byte is part of the first length prefix
+        return true;
+    }
+    if (first == kHandshakeSharedMemory && fd_count == 3) {
+        try {
+            conn.shm = ShmChannel::Attach(fds[0], fds[1], fds[2]);
+            return true;
+        } catch (const std::runtime_error &e) {
+            logger().Log(e.what());
+            return false;
+        }
+    }
+
+    logger().Log("Invalid handshake received: " + std::to_string(first));
+    for (int i = 0; i < std::min(fd_count, 3); ++i) {
+        close(fds[i]);
+    }
+    return false;
+}
+
+/** 
+ * @brief Starts serving a client that switched to the shared memory transport.
+ *
+ * @param epoll_fd The epoll instance.
+ * @param conn The connection owning the attached channel.
+ * @return false if the channel cannot be watched.
+ */
+bool Service::WatchSharedMemory(int epoll_fd, const std::shared_ptr<Connection> &conn) {
+    int event_fd = conn->shm->event_fd(ShmChannel::kRequest);
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_[event_fd] = conn;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = event_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev) < 0) {
+        logger().Log("Failed to watch shared memory channel: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    unsigned char accepted = kHandshakeAccepted;
+    if (send(conn->fd, &accepted, sizeof(accepted), MSG_NOSIGNAL) != 1) {
+        return false;
+    }
+    logger().Log("Client switched to the shared memory transport.");
+    return true;
+}
+
+/** 
+ * @brief Reads everything available on a client socket and extracts complete frames.
+ *
+ * Every recv() goes straight into the free space of the connection's receive buffer
+ * and takes as many bytes as the socket holds, up to that space.
+ *
+ * @param conn The connection to read from.
+ * @param on_message Called once per complete message, in arrival order.
+ * @return false if the client disconnected or sent an invalid frame.
+ */
+bool Service::ReadFrames(Connection &conn, const FrameCallback &on_message) const {
+    while (true) {
+        uint64_t recv_start = Metrics::Now();
+        char *space = conn.buffer.Reserve(kMinReadSpace);
+        ssize_t received = recv(conn.fd, space, conn.buffer.writable(), MSG_DONTWAIT);
+        if (received > 0) {
+            conn.buffer.Commit(static_cast<std::size_t>(received));
+            metrics_.RecordSince(Metrics::kRecv, recv_start);
+            if (!ExtractFrames(conn, on_message)) {
+                return false;
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        // Open only if the socket is drained; 0 means the client disconnected
+        return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+/** 
+ * @brief Moves everything in a client's request ring to its buffer and extracts complete frames.
+ *
+ * @param conn The connection using the shared memory transport.
+ * @param on_message Called once per complete message, in arrival order.
+ * @return false if the ring is corrupt or the client sent an invalid frame.
+ */
+bool Service::ReadSharedMemoryFrames(Connection &conn, const FrameCallback &on_message) const {
+    while (true) {
+        uint64_t recv_start = Metrics::Now();
+        char *space = conn.buffer.Reserve(kMinReadSpace);
+        std::size_t copied = 0;
+        if (!conn.shm->Read(ShmChannel::kRequest, space, conn.buffer.writable(), &copied)) {
+            return false;
+        }
+        if (copied == 0) {
+            return true; // Drained, the client signals the eventfd again once it writes more
+        }
+        conn.buffer.Commit(copied);
+        metrics_.RecordSince(Metrics::kRecv, recv_start);
+        if (!ExtractFrames(conn, on_message)) {
+            return false;
+        }
+    }
+}
+
+/** 
+ * @brief Extracts every complete frame buffered for a connection.
+ *
+ * Frames are a 4-byte network order length followed by the message body. Partial
+ * frames stay buffered in the connection until the rest arrives. Complete frames
+ * are passed on as views into the buffer, without copying.
+ *
+ * @param conn The connection whose buffer is framed.
+ * @param on_message Called once per complete message, in arrival order.
+ * @return false if the client sent an invalid frame.
+ */
+bool Service::ExtractFrames(Connection &conn, const FrameCallback &on_message) const {
+    while (!conn.handshake_done && !conn.buffer.empty()) {
+        // Only reached by the io_uring backend, which cannot receive descriptors
+        unsigned char first = static_cast<unsigned char>(conn.buffer.readable()[0]);
+        if (first == kHandshakeCompact && !conn.compact) {
+            conn.compact = true;
+            conn.buffer.Consume(1);
+            unsigned char accepted = kHandshakeAccepted;
+            if (send(conn.fd, &accepted, sizeof(accepted), MSG_NOSIGNAL) != 1) {
+                return false;
+            }
+            continue;
+        }
+        if (first != 0) {
+            logger().Log("Handshake not supported by the io_uring backend.");
+            return false;
+        }
+        conn.handshake_done = true;
+    }
+
+    std::string_view data = conn.buffer.readable();
+    std::size_t offset = 0;
+    while (true) {
+        std::string_view body;
+        uint32_t msg_size = 0;
+        FrameStatus status = NextFrame(data.substr(offset), &body, &msg_size);
+        if (status == FrameStatus::kInvalid) {
+            logger().Log("Invalid message size received: " + std::to_string(msg_size));
+            return false;
+        }
+        if (status == FrameStatus::kIncomplete) {
+            break;
+        }
+        metrics_.Add(Metrics::kBytesIn, sizeof(uint32_t) + msg_size);
+        on_message(body);
+        offset += sizeof(uint32_t) + msg_size;
+    }
+    conn.buffer.Consume(offset);
+    return true;
+}
+
+#ifdef HELLO_IPC_HAVE_IO_URING
+
+namespace {
+
+// Kind of request encoded in the top byte of an io_uring user_data value
+enum UringOp : uint64_t {
+    kUringAccept = 1,
+    kUringRecv,
+    kUringWake,
+    kUringSendHead,
+    kUringSendBody,
+    kUringCancel,
+};
+
+const unsigned kUringEntries = 256;
+const uint16_t kUringBufferGroup = 0;
+const uint16_t kUringBufferCount = 256;
+const uint32_t kUringBufferSize = 4096;
+const unsigned kUringBatch = 64;
+
+uint64_t UringTag(UringOp op, uint64_t value) { return (static_cast<uint64_t>(op) << 56) | value; }
+UringOp UringTagOp(uint64_t user_data) { return static_cast<UringOp>(user_data >> 56); }
+uint64_t UringTagValue(uint64_t user_data) { return user_data & ((1ULL << 56) - 1); }
+
+// Marks a thread as using the ring for its lifetime, so the loop does not tear the ring down under it
+class UringUser {
+    public:
+        explicit UringUser(std::atomic<int> &users) : users_(users) { ++users_; }
+        ~UringUser() { --users_; }
+
+        UringUser(const UringUser &) = delete;
+        UringUser &operator=(const UringUser &) = delete;
+
+    private:
+        std::atomic<int> &users_;
+};
+
+} // namespace
+
+/** 
+ * @brief Serves clients with io_uring completions.
+ *
+ * The listening socket uses a multishot accept and every client a multishot recv
+ * that picks buffers from a provided buffer ring, so reads cost no syscalls of their
+ * own. Each loop iteration submits all queued requests and reaps every available
+ * completion. Both features are probed first: on a kernel without them nothing is
+ * served and RunServer() falls back to epoll.
+ *
+ * @param server_fd The listening socket.
+ * @param wake_fd Eventfd signalled by StopServer().
+ * @param message_handler A function to handle incoming messages from clients.
+ * @return false if io_uring is not usable, in which case nothing was served.
+ */
+bool Service::RunIoUringLoop(int server_fd, int wake_fd, const MessageHandler &message_handler) {
+    std::unique_ptr<IoUring> ring;
+    try {
+        ring = std::make_unique<IoUring>(kUringEntries);
+    } catch (const std::runtime_error &e) {
+        logger().Log(e.what());
+        return false;
+    }
+    if (!ring->SetupBufferRing(kUringBufferGroup, kUringBufferCount, kUringBufferSize)) {
+        logger().Log("Failed to register io_uring buffer ring: " + std::string(strerror(errno)));
+        return false;
+    }
+    if (!ring->ProbeMultishotRecv(kUringBufferGroup)) {
+        logger().Log("io_uring multishot recv is not supported by the kernel.");
+        return false;
+    }
+
+    uint64_t wake_value = 0;
+    if (!ring->QueueMultishotAccept(server_fd, UringTag(kUringAccept, 0)) ||
+        !ring->QueueRead(wake_fd, &wake_value, sizeof(wake_value), UringTag(kUringWake, 0))) {
+        logger().Log("Failed to queue io_uring requests.");
+        return false;
+    }
+    uring_ = ring.get();
+
+    std::vector<IoUring::Completion> completions(kUringBatch);
+    {
+        // The pools are drained before the ring goes away, workers may still queue sends
+        WorkerPool workers[kLaneCount];
+
+        auto handle_recv = [&](const IoUring::Completion &cqe) {
+            int fd = static_cast<int>(UringTagValue(cqe.user_data));
+            std::shared_ptr<Connection> conn = FindConnection(fd);
+
+            bool open = cqe.res > 0 || cqe.res == -ENOBUFS;
+            if (cqe.res > 0 && IoUring::HasBuffer(cqe.flags)) {
+                uint16_t bid = IoUring::BufferId(cqe.flags);
+                if (conn) {
+                    conn->buffer.Append(ring->BufferData(bid), static_cast<std::size_t>(cqe.res));
                 }
+                ring->RecycleBuffer(bid);
+            }
+            if (!conn) {
+                return;
+            }
+            if (conn->closing) {
+                // Drop the client only once its multishot recv ended, so a stale completion
+                // can never be matched to a new client that reuses the descriptor
+                if (!IoUring::HasMore(cqe.flags)) {
+                    RemoveConnection(fd);
+                }
+                return;
+            }
+            if (open && !ExtractFrames(*conn, [&](std::string_view message) {
+                    Dispatch(workers, conn, message, message_handler);
+                })) {
+                shutdown(fd, SHUT_RDWR);
+                conn->closing = true;
+                open = IoUring::HasMore(cqe.flags);
+            }
+            if (open && !IoUring::HasMore(cqe.flags) &&
+                !ring->QueueMultishotRecv(fd, kUringBufferGroup, UringTag(kUringRecv, static_cast<uint64_t>(fd)))) {
+                logger().Log("Failed to queue io_uring recv, disconnecting client.");
+                shutdown(fd, SHUT_RDWR);
+                open = false;
+            }
+            if (!open) {
+                RemoveConnection(fd);
+            }
+        };
 
-                std::vector<char> buffer(msg_size);
+        bool running = true;
+        bool accept_armed = true;
+        while (running) {
+            int ret = ring->Submit(1);
+            if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                logger().Log("io_uring_enter failed: " + std::string(strerror(-ret)));
+                break;
+            }
+            if (!accept_armed) {
+                // The submission queue was full when the accept ended, it has been flushed since
+                accept_armed = ring->QueueMultishotAccept(server_fd, UringTag(kUringAccept, 0));
+            }
 
-                // Read the exact number of bytes for the message body
-                received = recv(client_socket, buffer.data(), msg_size, MSG_WAITALL);
-                if (received <= 0) {
-                    break; // Client disconnected or error
+            unsigned n;
+            while ((n = ring->ReapCompletions(completions.data(), kUringBatch)) > 0) {
+                for (unsigned i = 0; i < n; ++i) {
+                    const IoUring::Completion &cqe = completions[i];
+                    switch (UringTagOp(cqe.user_data)) {
+                        case kUringAccept:
+                            if (cqe.res >= 0 && AdmitConnection(cqe.res)) {
+                                AddConnection(cqe.res);
+                                if (!ring->QueueMultishotRecv(cqe.res, kUringBufferGroup,
+                                                              UringTag(kUringRecv, static_cast<uint64_t>(cqe.res)))) {
+                                    logger().Log("Failed to queue io_uring recv, disconnecting client.");
+                                    shutdown(cqe.res, SHUT_RDWR);
+                                    RemoveConnection(cqe.res);
+                                }
+                            } else if (cqe.res < 0) {
+                                logger().Log("io_uring accept failed: " + std::string(strerror(-cqe.res)));
+                            }
+                            if (!IoUring::HasMore(cqe.flags)) {
+                                accept_armed = ring->QueueMultishotAccept(server_fd, UringTag(kUringAccept, 0));
+                            }
+                            break;
+                        case kUringRecv:
+                            handle_recv(cqe);
+                            break;
+                        case kUringWake:
+                            running = false;
+                            break;
+                        case kUringSendHead:
+                            break; // The body completion reports the outcome of the pair
+                        case kUringSendBody:
+                            OnSendComplete(*ring, reinterpret_cast<Connection *>(UringTagValue(cqe.user_data)),
+                                           cqe.res, false);
+                            break;
+                        case kUringCancel:
+                        default:
+                            break;
+                    }
                 }
+            }
+        }
+    }
 
-                if (received == static_cast<ssize_t>(msg_size)) {
-                    handler(client_socket, std::string(buffer.begin(), buffer.end()));
+    // Fail every outstanding request and wait for the sends that still own connections. The sockets
+    // are shut down first, so threads that no longer see the ring cannot write into a live stream.
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto &entry : connections_) {
+            shutdown(entry.first, SHUT_RDWR);
+        }
+    }
+    uring_ = nullptr;
+    while (uring_users_ > 0) {
+        std::this_thread::yield(); // Threads outside the pools, e.g. notifiers, may still be queueing
+    }
+    if (!ring->QueueCancelAll(UringTag(kUringCancel, 0))) {
+        logger().Log("Failed to queue io_uring cancel.");
+    }
+    while (uring_sends_in_flight_ > 0) {
+        int ret = ring->Submit(1);
+        if (ret < 0 && ret != -EINTR) {
+            break;
+        }
+        unsigned n;
+        while ((n = ring->ReapCompletions(completions.data(), kUringBatch)) > 0) {
+            for (unsigned i = 0; i < n; ++i) {
+                if (UringTagOp(completions[i].user_data) == kUringSendBody) {
+                    OnSendComplete(*ring, reinterpret_cast<Connection *>(UringTagValue(completions[i].user_data)),
+                                   completions[i].res, true);
                 }
             }
-            logger().Log("Client disconnected.");
-            std::cout << "Client disconnected. ID: " << client_socket << std::endl;
-            close(client_socket);
-        }).detach();
+        }
     }
+    return true;
 }
 
+/** 
+ * @brief Sends a framed response through io_uring.
+ *
+ * Responses of one client are sent one linked header/body pair at a time so that
+ * concurrent sends can never interleave on the stream. A client with more than
+ * kMaxUnsentBytes of responses waiting is disconnected.
+ *
+ * @param client_socket The client socket.
+ * @param message The response body.
+ * @return false if the io_uring loop is not running, in which case nothing was done.
+ */
+bool Service::SendResponseIoUring(int client_socket, const std::string &message) const {
+    UringUser user(uring_users_);
+    IoUring *ring = uring_;
+    if (!ring) {
+        return false;
+    }
+    std::shared_ptr<Connection> conn = FindConnection(client_socket);
+    if (!conn) {
+        logger().Log("Failed to send response, client is gone.");
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(conn->send_mutex);
+        if (conn->send_queue_bytes > kMaxUnsentBytes) {
+            logger().Log("Disconnecting a client that does not read its responses.");
+            shutdown(conn->fd, SHUT_RDWR); // Fails the send in flight, which drops the queue
+            return true;
+        }
+        conn->send_queue.push_back({htonl(static_cast<uint32_t>(message.length())), message});
+        conn->send_queue_bytes += sizeof(uint32_t) + message.length();
+        if (conn->send_keepalive) {
+            return true; // The completion of the pair in flight submits this one
+        }
+        if (!SubmitNextSend(*ring, *conn)) {
+            conn->send_queue.clear();
+            conn->send_queue_bytes = 0;
+            return true;
+        }
+        conn->send_keepalive = conn;
+    }
+    ring->Submit();
+    return true;
+}
+
+/** 
+ * @brief Queues the linked header/body sends for the oldest pending response.
+ *
+ * Must be called with the connection's send_mutex held.
+ *
+ * @param ring The ring of the running loop.
+ * @param conn The connection whose send queue is not empty.
+ * @return false if the ring takes no more requests. The client is disconnected then,
+ * since its stream would have a gap.
+ */
+bool Service::SubmitNextSend(IoUring &ring, Connection &conn) const {
+    const auto &frame = conn.send_queue.front();
+    if (!ring.QueueLinkedSend(conn.fd, &frame.first, sizeof(frame.first), UringTag(kUringSendHead, 0),
+                              frame.second.data(), frame.second.size(),
+                              UringTag(kUringSendBody, reinterpret_cast<uint64_t>(&conn)))) {
+        logger().Log("Failed to queue io_uring send, disconnecting client.");
+        shutdown(conn.fd, SHUT_RDWR);
+        return false;
+    }
+    ++uring_sends_in_flight_;
+    return true;
+}
+
+/** 
+ * @brief Completes the response in flight and starts the next one.
+ *
+ * @param ring The ring of the running loop.
+ * @param conn The connection, kept alive by its send_keepalive reference.
+ * @param result Result of the body send.
+ * @param stopping true while the server shuts down; pending responses are dropped.
+ */
+void Service::OnSendComplete(IoUring &ring, Connection *conn, int result, bool stopping) {
+    std::shared_ptr<Connection> release;
+    bool submit = false;
+    {
+        std::lock_guard<std::mutex> lock(conn->send_mutex);
+        --uring_sends_in_flight_;
+        if (result < 0) {
+            logger().Log("Failed to send response to client: " + std::string(strerror(-result)));
+        }
+        conn->send_queue_bytes -= sizeof(uint32_t) + conn->send_queue.front().second.length();
+        conn->send_queue.pop_front();
+        if (stopping || result < 0) {
+            conn->send_queue.clear(); // The stream is broken, later frames would not line up
+            conn->send_queue_bytes = 0;
+        }
+        if (!conn->send_queue.empty()) {
+            submit = SubmitNextSend(ring, *conn);
+            if (!submit) {
+                conn->send_queue.clear();
+                conn->send_queue_bytes = 0;
+            }
+        }
+        if (conn->send_queue.empty()) {
+            release = std::move(conn->send_keepalive); // May free conn once the lock is gone
+        }
+    }
+    if (submit) {
+        ring.Submit();
+    }
+}
+
+#else
+
+bool Service::RunIoUringLoop(int, int, const MessageHandler &) {
+    return false;
+}
+
+bool Service::SendResponseIoUring(int, const std::string &) const {
+    return false;
+}
+
+#endif // HELLO_IPC_HAVE_IO_URING
+
 /** 
  * @brief Sends a message to the connected server.
  *
@@ -132,16 +1257,59 @@ void Service::SendMessage(const std::string &message) const {
         logger().Log("Not connected, cannot send message.");
         return;
     }
-    // Send the size of the message first
+    if (shm_) {
+        uint32_t msg_size = htonl(message.length());
+        if (!shm_->Write(ShmChannel::kRequest, &msg_size, sizeof(msg_size),
+                         message.data(), message.length(), kShmTimeoutMs)) {
+            logger().Log("Failed to write message to the shared memory ring.");
+        }
+        return;
+    }
+
+    // Length prefix and body leave in one sendmsg
     uint32_t msg_size = htonl(message.length()); // Use network byte order
-    if (send(sockfd_, &msg_size, sizeof(msg_size), 0) < 0) {
-        logger().Log("Failed to send message size: " + std::string(strerror(errno)));
+    struct iovec iov[2] = {{&msg_size, sizeof(msg_size)},
+                           {const_cast<char *>(message.data()), message.length()}};
+    if (!WriteFully(sockfd_, iov, 2)) {
+        logger().Log("Failed to send message: " + std::string(strerror(errno)));
+    }
+}
+
+/** 
+ * @brief Sends several messages to the connected server at once.
+ *
+ * All length prefixes and bodies are gathered into a single sendmsg call, so a
+ * batch of pipelined requests costs one syscall instead of two per message.
+ *
+ * @param messages The messages to send, in order.
+ */
+void Service::SendMessages(const std::vector<std::string> &messages) const {
+    if (sockfd_ < 0) {
+        logger().Log("Not connected, cannot send message.");
         return;
     }
+    if (shm_) {
+        for (const auto &message : messages) {
+            uint32_t msg_size = htonl(message.length());
+            if (!shm_->Write(ShmChannel::kRequest, &msg_size, sizeof(msg_size),
+                             message.data(), message.length(), kShmTimeoutMs)) {
+                logger().Log("Failed to write message to the shared memory ring.");
+                return;
+            }
+        }
+        return;
+    }
+
+    std::vector<uint32_t> sizes(messages.size());
+    std::vector<struct iovec> iov(2 * messages.size());
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        sizes[i] = htonl(messages[i].length()); // Use network byte order
+        iov[2 * i] = {&sizes[i], sizeof(sizes[i])};
+        iov[2 * i + 1] = {const_cast<char *>(messages[i].data()), messages[i].length()};
+    }
 
-    // Then send the message itself
-    if (send(sockfd_, message.c_str(), message.length(), 0) < 0) {
-        logger().Log("Failed to send message data: " + std::string(strerror(errno)));
+    if (!WriteFully(sockfd_, iov.data(), iov.size())) {
+        logger().Log("Failed to send messages: " + std::string(strerror(errno)));
     }
 }
 
@@ -152,22 +1320,180 @@ void Service::SendMessage(const std::string &message) const {
  * @param message The message to send as a response.
  */
 void Service::SendResponse(int client_socket, const std::string &message) const {
-    // Send the size of the message first
+    uint64_t send_start = Metrics::Now();
+    metrics_.Add(Metrics::kBytesOut, sizeof(uint32_t) + message.length());
+
+    std::shared_ptr<Connection> found;
+    Connection *conn = current_connection_;
+    if (!conn || conn->fd != client_socket) {
+        found = FindConnection(client_socket);
+        conn = found.get();
+    }
+    if (conn && conn->shm) {
+        uint32_t msg_size = htonl(message.length());
+        struct iovec iov[2] = {{&msg_size, sizeof(msg_size)},
+                               {const_cast<char *>(message.data()), message.length()}};
+        std::lock_guard<std::mutex> lock(conn->send_mutex); // The ring has a single producer
+        WriteToClient(*conn, iov, 2);
+        metrics_.RecordSince(Metrics::kSend, send_start);
+        return;
+    }
+
+    if (uring_ && SendResponseIoUring(client_socket, message)) { // Only queues the send
+        metrics_.RecordSince(Metrics::kSend, send_start);
+        return;
+    }
+
     uint32_t msg_size = htonl(message.length());
-    if (send(client_socket, &msg_size, sizeof(msg_size), 0) < 0) {
-        logger().Log("Failed to send response size to client.");
+    LaneState *lane = conn && conn == current_connection_
+                                      ? &conn->lanes[static_cast<std::size_t>(current_lane_)] : nullptr;
+    if (lane && (lane->queued.load(std::memory_order_relaxed) > 1 || !lane->outbox.empty())) {
+        // More requests of this client are queued in the lane, send the responses together afterwards
+        lane->outbox.append(reinterpret_cast<const char *>(&msg_size), sizeof(msg_size));
+        lane->outbox.append(message);
+        if (lane->outbox.size() >= kMaxCorkedBytes) {
+            FlushResponses(*conn, *lane);
+        }
+        metrics_.RecordSince(Metrics::kSend, send_start);
+        return;
+    }
+
+    // Length prefix and body leave in one sendmsg
+    struct iovec iov[2] = {{&msg_size, sizeof(msg_size)},
+                           {const_cast<char *>(message.data()), message.length()}};
+    if (conn) {
+        std::lock_guard<std::mutex> lock(conn->send_mutex); // Keeps frames of concurrent senders apart
+        WriteToClient(*conn, iov, 2);
+    } else if (!WriteFully(client_socket, iov, 2)) { // Not served by the event loop
+        logger().Log("Failed to send response to client: " + std::string(strerror(errno)));
+    }
+    metrics_.RecordSince(Metrics::kSend, send_start);
+}
+
+/** 
+ * @brief Sends the responses corked for the client whose message this worker handles.
+ *
+ * Does nothing outside a message handler.
+ */
+void Service::FlushHeldResponses() const {
+    if (current_connection_) {
+        FlushResponses(*current_connection_, current_connection_->lanes[static_cast<std::size_t>(current_lane_)]);
+    }
+}
+
+/** 
+ * @brief Sends every corked response of a connection's lane in a single write.
+ *
+ * @param conn The connection.
+ * @param lane Its state in the lane of the calling worker.
+ */
+void Service::FlushResponses(Connection &conn, LaneState &lane) const {
+    if (lane.outbox.empty()) {
+        return;
+    }
+    struct iovec iov = {lane.outbox.data(), lane.outbox.size()};
+    {
+        std::lock_guard<std::mutex> lock(conn.send_mutex);
+        WriteToClient(conn, &iov, 1);
+    }
+    lane.outbox.clear();
+}
+
+/** 
+ * @brief Writes framed responses to a client without waiting for it.
+ *
+ * Whatever the socket or response ring does not take right away is kept in the
+ * connection and sent by the event loop once there is room again; later responses
+ * queue behind it, so frames stay in order. A client that falls more than kMaxUnsentBytes
+ * behind is disconnected, so a client that does not read cannot hold a worker or
+ * make the server buffer without bound.
+ *
+ * Must be called with the connection's send_mutex held.
+ *
+ * @param conn The connection.
+ * @param iov The framed responses.
+ * @param iovcnt Number of buffers.
+ * @return false if the client is being disconnected.
+ */
+bool Service::WriteToClient(Connection &conn, struct iovec *iov, std::size_t iovcnt) const {
+    if (conn.unsent.empty() && !WriteAvailable(conn, &iov, &iovcnt)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < iovcnt; ++i) {
+        conn.unsent.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    if (conn.unsent.size() > kMaxUnsentBytes) {
+        logger().Log("Disconnecting a client that does not read its responses.");
+        conn.unsent.clear();
+        shutdown(conn.fd, SHUT_RDWR); // The event loop sees the hangup and drops the connection
+        return false;
+    }
+    return true;
+}
+
+/** 
+ * @brief Sends the responses a client did not take earlier, once it has room again.
+ *
+ * Called by the event loop when the socket is writable, or when a shared memory
+ * client signals that it read from a full response ring.
+ *
+ * @param conn The connection.
+ */
+void Service::FlushUnsent(Connection &conn) const {
+    std::lock_guard<std::mutex> lock(conn.send_mutex);
+    if (conn.unsent.empty()) {
+        return;
+    }
+    struct iovec iov = {conn.unsent.data(), conn.unsent.size()};
+    struct iovec *left = &iov;
+    std::size_t count = 1;
+    if (!WriteAvailable(conn, &left, &count)) {
+        conn.unsent.clear();
         return;
     }
+    conn.unsent.erase(0, conn.unsent.size() - (count > 0 ? iov.iov_len : 0));
+}
+
+/** 
+ * @brief Writes as much of iov to a client as its socket or response ring takes without waiting.
+ *
+ * @param conn The connection.
+ * @param iov The buffers to send; advanced past the bytes written.
+ * @param iovcnt Number of buffers; reduced to the ones not written completely.
+ * @return false if the transport failed, which is logged.
+ */
+bool Service::WriteAvailable(Connection &conn, struct iovec **iov, std::size_t *iovcnt) const {
+    if (!conn.shm) {
+        if (!WriteIov(conn.fd, iov, iovcnt, MSG_DONTWAIT)) {
+            logger().Log("Failed to send response to client: " + std::string(strerror(errno)));
+            return false;
+        }
+        return true;
+    }
 
-    // Then send the message itself
-    if (send(client_socket, message.c_str(), message.length(), 0) < 0) {
-        logger().Log("Failed to send response data to client.");
+    while (*iovcnt > 0) {
+        std::size_t written = 0;
+        if (!conn.shm->WriteSome(ShmChannel::kResponse, (*iov)->iov_base, (*iov)->iov_len, &written)) {
+            logger().Log("Shared memory response ring is corrupt.");
+            return false;
+        }
+        if (written < (*iov)->iov_len) {
+            (*iov)->iov_base = static_cast<char *>((*iov)->iov_base) + written;
+            (*iov)->iov_len -= written;
+            return true; // The ring is full
+        }
+        ++*iov;
+        --*iovcnt;
     }
+    return true;
 }
 
 /** 
  * @brief Receives a message from the connected server.
  *
+ * Reads as many bytes as are available into the receive buffer, so responses that
+ * arrive together are returned by later calls without another system call.
+ *
  * @return The received message.
  */
 std::optional<std::string> Service::ReceiveMessage() {
@@ -176,40 +1502,75 @@ std::optional<std::string> Service::ReceiveMessage() {
         return std::nullopt;
     }
 
-    SetupSocketTimeout(sockfd_);
-
-    uint32_t msg_size;
-    // Read the 4-byte size prefix
-    ssize_t received = recv(sockfd_, &msg_size, sizeof(msg_size), MSG_WAITALL);
-    if (received <= 0) {
-        if (received == 0) {
-            logger().Log("Connection closed by server.");
-        } else {
-            logger().Log("Error receiving message size from server.");
+    while (true) {
+        std::string_view body;
+        uint32_t msg_size = 0;
+        FrameStatus status = NextFrame(receive_buffer_.readable(), &body, &msg_size);
+        if (status == FrameStatus::kInvalid) {
+            logger().Log("Invalid message size received: " + std::to_string(msg_size));
+            receive_buffer_.Clear();
+            return std::nullopt;
+        }
+        if (status == FrameStatus::kComplete) {
+            std::string message(body);
+            receive_buffer_.Consume(sizeof(uint32_t) + msg_size);
+            return message;
         }
-        return std::nullopt;
-    }
 
-    msg_size = ntohl(msg_size);
-    if (msg_size == 0 || msg_size > kMaxMessageSize) { // Basic sanity check
-        logger().Log("Invalid message size received: " + std::to_string(msg_size));
-        return std::nullopt;
+        if (!(shm_ ? ReceiveSharedMemoryBytes() : ReceiveSocketBytes())) {
+            return std::nullopt;
+        }
     }
+}
 
-    std::vector<char> buffer(msg_size);
-
-    // Read the exact number of bytes for the message body
-    received = recv(sockfd_, buffer.data(), msg_size, MSG_WAITALL);
-    if (received <= 0) {
+/** 
+ * @brief Waits for more bytes from the server socket and appends them to the receive buffer.
+ *
+ * @return false if the connection was closed or the receive timed out.
+ */
+bool Service::ReceiveSocketBytes() {
+    while (true) {
+        char *space = receive_buffer_.Reserve(kMinReadSpace);
+        ssize_t received = recv(sockfd_, space, receive_buffer_.writable(), 0);
+        if (received > 0) {
+            receive_buffer_.Commit(static_cast<std::size_t>(received));
+            return true;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
         if (received == 0) {
-            logger().Log("Connection closed by server during message read.");
+            logger().Log("Connection closed by server.");
         } else {
-            logger().Log("Error receiving message data from server.");
+            logger().Log("Error receiving message from server.");
         }
-        return std::nullopt;
+        return false;
     }
+}
 
-    return std::string(buffer.begin(), buffer.end());
+/** 
+ * @brief Waits for more bytes in the shared memory response ring and appends them to the receive buffer.
+ *
+ * @return false on timeout or if the ring is corrupt.
+ */
+bool Service::ReceiveSharedMemoryBytes() {
+    while (true) {
+        char *space = receive_buffer_.Reserve(kMinReadSpace);
+        std::size_t copied = 0;
+        if (!shm_->Read(ShmChannel::kResponse, space, receive_buffer_.writable(), &copied)) {
+            logger().Log("Shared memory response ring is corrupt.");
+            return false;
+        }
+        if (copied > 0) {
+            receive_buffer_.Commit(copied);
+            return true;
+        }
+        if (!shm_->WaitReadable(ShmChannel::kResponse, receive_timeout_ms_ > 0 ? receive_timeout_ms_ : kShmTimeoutMs) &&
+            receive_timeout_ms_ > 0) {
+            logger().Log("Timed out waiting for a response from server.");
+            return false;
+        }
+    }
 }
 
 /** 
@@ -221,8 +1582,8 @@ std::optional<std::string> Service::ReceiveMessage() {
  */
 void Service::SetupSocketTimeout(int sockfd) const {
     struct timeval timeout;
-    timeout.tv_sec = 5;
-    timeout.tv_usec = 0;
+    timeout.tv_sec = receive_timeout_ms_ / 1000;
+    timeout.tv_usec = (receive_timeout_ms_ % 1000) * 1000;
 
     // Set the socket receive timeout
     if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
@@ -231,11 +1592,25 @@ void Service::SetupSocketTimeout(int sockfd) const {
     }
 
     // Set the socket send timeout
+    timeout.tv_sec = 5;
+    timeout.tv_usec = 0;
     if (setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0) {
         logger().Log("Failed to set socket send timeout: " + std::string(strerror(errno)));
     }
 }
 
+/** 
+ * @brief Changes how long ReceiveMessage() waits for the server.
+ *
+ * @param timeout_ms The new timeout; 0 waits until a message arrives or the connection fails.
+ */
+void Service::SetReceiveTimeout(int timeout_ms) {
+    receive_timeout_ms_ = timeout_ms;
+    if (sockfd_ >= 0) {
+        SetupSocketTimeout(sockfd_);
+    }
+}
+
 /** 
  * @brief Creates a server socket and binds it to the specified path.
  *
@@ -263,7 +1638,7 @@ int Service::CreateServerSocket(const std::string &socket_path) const {
         return -1;
     }
 
-    if (listen(server_fd, 10) < 0) {
+    if (listen(server_fd, limits_.backlog) < 0) {
         logger().Log("Failed to listen on server socket: " + std::string(strerror(errno)));
         close(server_fd);
         return -1;
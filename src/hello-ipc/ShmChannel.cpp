@@ -0,0 +1,420 @@
+#include "ShmChannel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hello_ipc {
+
+namespace {
+
+const uint32_t kShmMagic = 0x48495043; // "HIPC"
+const int kSpinIterations = 2000;
+const int kSizeSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+int RemainingMs(std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+}
+
+} // namespace
+
+/**
+ * @brief Header at the start of the shared memory, followed by the two ring buffers.
+ *
+ * Every cursor lives on its own cache line so producer and consumer never share one.
+ * Cursors only grow; the ring offset is the cursor modulo the capacity.
+ */
+struct ShmChannel::Layout {
+    struct alignas(64) Cursor {
+        std::atomic<uint64_t> value;
+    };
+
+    uint32_t magic;
+    uint32_t capacity;
+    Cursor heads[2]; // Next byte to read, owned by the consumer
+    Cursor tails[2]; // Next byte to write, owned by the producer
+    Cursor stalled[2]; // Set by a producer that found the ring full, cleared by the consumer
+};
+
+struct ShmChannel::Ring {
+    std::atomic<uint64_t> *head;
+    std::atomic<uint64_t> *tail;
+    std::atomic<uint64_t> *stalled;
+    char *data;
+    uint64_t capacity;
+};
+
+/**
+ * @brief Creates a new channel in a memfd.
+ *
+ * @param ring_capacity Bytes per ring, rounded up to a power of two.
+ * @return The mapped channel.
+ * @throws std::runtime_error if any resource cannot be created.
+ */
+std::unique_ptr<ShmChannel> ShmChannel::Create(std::size_t ring_capacity) {
+    ring_capacity = RoundUpToPowerOfTwo(std::max<std::size_t>(ring_capacity, 4096));
+    std::size_t size = sizeof(Layout) + 2 * ring_capacity;
+
+    int memfd = memfd_create("hello_ipc_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        throw std::runtime_error("memfd_create failed: " + std::string(strerror(errno)));
+    }
+    if (ftruncate(memfd, static_cast<off_t>(size)) < 0 || fcntl(memfd, F_ADD_SEALS, kSizeSeals | F_SEAL_SEAL) < 0) {
+        std::string error = strerror(errno);
+        close(memfd);
+        throw std::runtime_error("Failed to size shared memory: " + error);
+    }
+
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (base == MAP_FAILED) {
+        std::string error = strerror(errno);
+        close(memfd);
+        throw std::runtime_error("Failed to map shared memory: " + error);
+    }
+
+    Layout *layout = new (base) Layout();
+    layout->magic = kShmMagic;
+    layout->capacity = static_cast<uint32_t>(ring_capacity);
+
+    int request_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int response_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (request_event_fd < 0 || response_event_fd < 0) {
+        std::string error = strerror(errno);
+        if (request_event_fd >= 0) close(request_event_fd);
+        if (response_event_fd >= 0) close(response_event_fd);
+        munmap(base, size);
+        close(memfd);
+        throw std::runtime_error("Failed to create eventfd: " + error);
+    }
+
+    return std::unique_ptr<ShmChannel>(new ShmChannel(memfd, request_event_fd, response_event_fd, base, size,
+                                                      ring_capacity));
+}
+
+/**
+ * @brief Maps a channel created by a client.
+ *
+ * The layout is validated because the memory is writable by the client, and the
+ * size must be sealed, since a client that shrinks it would make every access to
+ * the mapping fault. The validated capacity is kept outside the mapping, so a
+ * client that rewrites the header later cannot move the rings past its end.
+ *
+ * @param memfd The shared memory descriptor.
+ * @param request_event_fd Eventfd signalled when the request ring gets data.
+ * @param response_event_fd Eventfd signalled when the response ring gets data.
+ * @return The mapped channel, owning the three descriptors.
+ * @throws std::runtime_error if the memory does not hold a valid channel.
+ */
+std::unique_ptr<ShmChannel> ShmChannel::Attach(int memfd, int request_event_fd, int response_event_fd) {
+    auto fail = [&](const std::string &reason) {
+        close(memfd);
+        close(request_event_fd);
+        close(response_event_fd);
+        throw std::runtime_error("Invalid shared memory channel: " + reason);
+    };
+
+    int seals = fcntl(memfd, F_GET_SEALS);
+    if (seals < 0 || (seals & kSizeSeals) != kSizeSeals) {
+        fail("size not sealed");
+    }
+    struct stat st;
+    if (fstat(memfd, &st) < 0 || static_cast<std::size_t>(st.st_size) < sizeof(Layout)) {
+        fail("too small");
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (base == MAP_FAILED) {
+        fail(strerror(errno));
+    }
+
+    const Layout *layout = static_cast<const Layout *>(base);
+    std::size_t capacity = layout->capacity;
+    if (layout->magic != kShmMagic || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        sizeof(Layout) + 2 * capacity != size) {
+        munmap(base, size);
+        fail("bad header");
+    }
+
+    return std::unique_ptr<ShmChannel>(new ShmChannel(memfd, request_event_fd, response_event_fd, base, size,
+                                                      capacity));
+}
+
+ShmChannel::ShmChannel(int memfd, int request_event_fd, int response_event_fd, void *base, std::size_t size,
+                       std::size_t capacity)
+    : memfd_(memfd), event_fds_{request_event_fd, response_event_fd}, base_(base), size_(size),
+      capacity_(capacity) {}
+
+/**
+ * @brief Unmaps the memory and closes the descriptors.
+ */
+ShmChannel::~ShmChannel() {
+    munmap(base_, size_);
+    close(memfd_);
+    close(event_fds_[kRequest]);
+    close(event_fds_[kResponse]);
+}
+
+ShmChannel::Ring ShmChannel::RingFor(Direction direction) const {
+    Layout *layout = static_cast<Layout *>(base_);
+    char *data = static_cast<char *>(base_) + sizeof(Layout) + direction * capacity_;
+    return {&layout->heads[direction].value, &layout->tails[direction].value, &layout->stalled[direction].value,
+            data, capacity_};
+}
+
+/**
+ * @brief Wakes the producer of a ring if it found the ring full, after the consumer freed space.
+ *
+ * A producer waits for room on the eventfd of the ring it consumes itself.
+ *
+ * @param direction The ring that got free space.
+ */
+void ShmChannel::WakeStalledProducer(Direction direction) {
+    Ring ring = RingFor(direction);
+    if (ring.stalled->load(std::memory_order_seq_cst) != 0 && ring.stalled->exchange(0, std::memory_order_seq_cst)) {
+        uint64_t one = 1;
+        ssize_t written = write(event_fds_[direction == kRequest ? kResponse : kRequest], &one, sizeof(one));
+        (void)written; // A saturated counter still reads as a wakeup
+    }
+}
+
+/**
+ * @brief Appends head and body to a ring as one unit.
+ *
+ * Signals the consumer's eventfd only if the ring was empty before the write.
+ *
+ * @param direction The ring to write to.
+ * @param head First bytes to write (the frame length).
+ * @param head_len Size of head.
+ * @param body Bytes written right after head.
+ * @param body_len Size of body.
+ * @param timeout_ms How long to wait for the consumer to free space.
+ * @return false if the data does not fit or the consumer did not free space in time.
+ */
+bool ShmChannel::Write(Direction direction, const void *head, std::size_t head_len,
+                       const void *body, std::size_t body_len, int timeout_ms) {
+    Ring ring = RingFor(direction);
+    uint64_t total = head_len + body_len;
+    if (total > ring.capacity) {
+        return false;
+    }
+
+    uint64_t tail = ring.tail->load(std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (int spins = 0; tail - ring.head->load(std::memory_order_acquire) + total > ring.capacity; ++spins) {
+        if (spins < kSpinIterations) {
+            CpuRelax();
+        } else if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        } else {
+            usleep(50);
+        }
+    }
+
+    auto copy_in = [&ring](uint64_t pos, const void *src, std::size_t len) {
+        std::size_t offset = pos & (ring.capacity - 1);
+        std::size_t first = std::min<std::size_t>(len, ring.capacity - offset);
+        memcpy(ring.data + offset, src, first);
+        memcpy(ring.data, static_cast<const char *>(src) + first, len - first);
+    };
+    copy_in(tail, head, head_len);
+    copy_in(tail + head_len, body, body_len);
+
+    // Publish, then check whether the consumer may have gone to sleep on an empty ring.
+    // Both sides use sequentially consistent accesses so at least one sees the other.
+    ring.tail->store(tail + total, std::memory_order_seq_cst);
+    if (ring.head->load(std::memory_order_seq_cst) == tail) {
+        uint64_t one = 1;
+        ssize_t written = write(event_fds_[direction], &one, sizeof(one));
+        (void)written; // A saturated counter still reads as a wakeup
+    }
+    return true;
+}
+
+/**
+ * @brief Appends as many bytes to a ring as fit right now.
+ *
+ * Never waits for the consumer, so the server can write to a ring whose cursors
+ * the client controls. If not everything fits, the ring is marked stalled and the
+ * consumer signals the other direction's eventfd once it freed space; the space
+ * is checked again after marking, so that signal cannot be missed.
+ *
+ * @param direction The ring to write to.
+ * @param data The bytes to append.
+ * @param len Number of bytes.
+ * @param written Set to the number of bytes appended.
+ * @return false if the cursors are inconsistent, which only a broken peer can cause.
+ */
+bool ShmChannel::WriteSome(Direction direction, const void *data, std::size_t len, std::size_t *written) {
+    Ring ring = RingFor(direction);
+    const char *src = static_cast<const char *>(data);
+    *written = 0;
+
+    uint64_t tail = ring.tail->load(std::memory_order_relaxed);
+    bool marked = false;
+    while (*written < len) {
+        uint64_t used = tail - ring.head->load(std::memory_order_seq_cst);
+        if (used > ring.capacity) {
+            return false;
+        }
+        std::size_t count = std::min<uint64_t>(len - *written, ring.capacity - used);
+        if (count == 0) {
+            if (marked) {
+                break; // Still full after marking, the consumer signals once it reads
+            }
+            ring.stalled->store(1, std::memory_order_seq_cst);
+            marked = true;
+            continue;
+        }
+
+        std::size_t offset = tail & (ring.capacity - 1);
+        std::size_t first = std::min<std::size_t>(count, ring.capacity - offset);
+        memcpy(ring.data + offset, src + *written, first);
+        memcpy(ring.data, src + *written + first, count - first);
+
+        // Same handshake as Write(): wake the consumer if it may be asleep on an empty ring
+        ring.tail->store(tail + count, std::memory_order_seq_cst);
+        if (ring.head->load(std::memory_order_seq_cst) == tail) {
+            uint64_t one = 1;
+            ssize_t signalled = write(event_fds_[direction], &one, sizeof(one));
+            (void)signalled; // A saturated counter still reads as a wakeup
+        }
+        tail += count;
+        *written += count;
+        marked = false; // The consumer may have cleared the mark while making this room
+    }
+    return true;
+}
+
+/**
+ * @brief Moves every readable byte of a ring to out.
+ *
+ * @param direction The ring to read from.
+ * @param out Receives the bytes.
+ * @return false if the cursors are inconsistent, which only a broken peer can cause.
+ */
+bool ShmChannel::Drain(Direction direction, std::string &out) {
+    Ring ring = RingFor(direction);
+    uint64_t head = ring.head->load(std::memory_order_relaxed);
+
+    while (true) {
+        uint64_t tail = ring.tail->load(std::memory_order_seq_cst);
+        if (tail == head) {
+            return true;
+        }
+        uint64_t len = tail - head;
+        if (len > ring.capacity) {
+            return false;
+        }
+
+        std::size_t offset = head & (ring.capacity - 1);
+        std::size_t first = std::min<std::size_t>(len, ring.capacity - offset);
+        out.append(ring.data + offset, first);
+        out.append(ring.data, len - first);
+
+        head = tail;
+        ring.head->store(head, std::memory_order_seq_cst);
+        WakeStalledProducer(direction);
+    }
+}
+
+/**
+ * @brief Moves up to len readable bytes of a ring to out.
+ *
+ * @param direction The ring to read from.
+ * @param out Receives the bytes.
+ * @param len Space available at out.
+ * @param copied Set to the number of bytes moved, 0 if the ring is empty.
+ * @return false if the cursors are inconsistent, which only a broken peer can cause.
+ */
+bool ShmChannel::Read(Direction direction, char *out, std::size_t len, std::size_t *copied) {
+    Ring ring = RingFor(direction);
+    uint64_t head = ring.head->load(std::memory_order_relaxed);
+    uint64_t available = ring.tail->load(std::memory_order_seq_cst) - head;
+    *copied = 0;
+    if (available > ring.capacity) {
+        return false;
+    }
+
+    std::size_t count = std::min<uint64_t>(available, len);
+    std::size_t offset = head & (ring.capacity - 1);
+    std::size_t first = std::min<std::size_t>(count, ring.capacity - offset);
+    memcpy(out, ring.data + offset, first);
+    memcpy(out + first, ring.data, count - first);
+
+    ring.head->store(head + count, std::memory_order_seq_cst);
+    *copied = count;
+    if (count > 0) {
+        WakeStalledProducer(direction);
+    }
+    return true;
+}
+
+/**
+ * @brief Waits until a ring has data.
+ *
+ * @param direction The ring to wait on.
+ * @param timeout_ms Maximum time to sleep on the eventfd.
+ * @return true if data is available.
+ */
+bool ShmChannel::WaitReadable(Direction direction, int timeout_ms) {
+    Ring ring = RingFor(direction);
+    auto has_data = [&ring]() {
+        return ring.tail->load(std::memory_order_seq_cst) != ring.head->load(std::memory_order_relaxed);
+    };
+
+    for (int i = 0; i < kSpinIterations; ++i) {
+        if (has_data()) {
+            return true;
+        }
+        CpuRelax();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    struct pollfd pfd = {event_fds_[direction], POLLIN, 0};
+    while (!has_data()) {
+        int ready = poll(&pfd, 1, RemainingMs(deadline));
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready == 0) {
+            return has_data();
+        }
+        ClearSignal(direction);
+    }
+    return true;
+}
+
+void ShmChannel::ClearSignal(Direction direction) {
+    uint64_t value;
+    ssize_t received = read(event_fds_[direction], &value, sizeof(value));
+    (void)received; // EAGAIN just means there was nothing to clear
+}
+
+} // namespace hello_ipc
@@ -2,11 +2,75 @@
 #include "led_service.pb.h"
 
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <deque>
 
 namespace hello_ipc {
 
+namespace {
+
+// Maximum number of pipelined requests waiting for a response on the connection
+const std::size_t kMaxInFlight = 64;
+
+bool ParseLedName(const std::string &led_name, uint32_t *led_id) {
+    const char *last = led_name.data() + led_name.size();
+    auto result = std::from_chars(led_name.data(), last, *led_id);
+    return !led_name.empty() && result.ec == std::errc() && result.ptr == last;
+}
+
+/**
+ * @brief Identifies the LED of a request by numeric id, falling back to led_num.
+ *
+ * Names that are not a number fitting led_id are sent as led_num so the server
+ * reports the error.
+ */
+template <typename LedRequest>
+void SetLedId(LedRequest *req, const std::string &led_name) {
+    uint32_t led_id;
+    if (ParseLedName(led_name, &led_id)) {
+        req->set_led_id(led_id);
+    } else {
+        req->set_led_num(led_name);
+    }
+}
+
+std::string LedName(const hello_ipc::LedStateResponse &state_res) {
+    return state_res.has_led_id() ? std::to_string(state_res.led_id()) : state_res.led_num();
+}
+
+void PrintUpdateResponse(const hello_ipc::Response &res) {
+    if (res.has_state_response()) {
+        const auto& state_res = res.state_response();
+        if (!state_res.error_message().empty()) {
+            std::cout << "Error from server: " << state_res.error_message() << std::endl;
+        } else {
+            std::cout << "Response: Led" << LedName(state_res) << " Updated" << std::endl;
+        }
+    }
+}
+
+
+/**
+ * @brief Logs the outcome of a state response without formatting the whole message.
+ */
+void LogStateResponse(const Logger &logger, const hello_ipc::Response &res) {
+    const auto &state_res = res.state_response();
+    std::string_view outcome = state_res.error_message();
+    if (outcome.empty()) {
+        outcome = (state_res.state() == hello_ipc::LedState::ON) ? "on" : "off";
+    }
+    if (state_res.has_led_id()) {
+        logger.Log(LogId::kStateResponseReceived, res.request_id(), state_res.led_id(), outcome);
+    } else {
+        logger.Log(LogId::kStateResponseReceived, res.request_id(), state_res.led_num(), outcome);
+    }
+}
+
+} // namespace
+
 /** 
  * @brief Constructs an UpdateLed client that connects to the LedManager service.
  *
@@ -16,7 +80,7 @@ namespace hello_ipc {
  * @throws std::runtime_error if the socket connection fails.
  */
 UpdateLed::UpdateLed(const std::string &socket_path, int argc, char** argv, bool connect)
-    : Service("UpdateLed"), argc_(argc), argv_(argv) {
+    : Service("UpdateLed"), argc_(argc), argv_(argv), next_request_id_(1) {
     if (connect) {
         ConnectToServer(socket_path);
     }
@@ -41,20 +105,22 @@ void UpdateLed::Run() {
  * @brief Handles command-line arguments to send initial LED updates.
  *
  * This method processes arguments of the form "--led<number>" to send updates
- * for LEDs specified in the command line.
+ * for LEDs specified in the command line. The updates are pipelined.
  * 
  * @throws std::runtime_error if sending messages fails.
  */
 void UpdateLed::HandleArguments() {
+    std::vector<std::string> led_names;
     for (int i = 2; i < argc_; ++i) {
         std::string arg = argv_[i];
         if (arg.rfind("--led", 0) == 0) {
             std::string led_name = arg.substr(5);
             if (!led_name.empty()) {
-                SendUpdate(led_name, "on");
+                led_names.push_back(led_name);
             }
         }
     }
+    SendUpdates(led_names, "on");
 }
 
 /**
@@ -106,8 +172,9 @@ void UpdateLed::HandleUserInput(std::istream &input_stream) {
 void UpdateLed::SendUpdate(const std::string &led_name, const std::string &led_state) {
     hello_ipc::Request req;
     auto* update_req = req.mutable_update_request();
-    update_req->set_led_num(led_name);
+    SetLedId(update_req, led_name);
     update_req->set_state((led_state == "on") ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+    req.set_request_id(next_request_id_++);
 
     std::string message;
     if (!req.SerializeToString(&message)) {
@@ -116,7 +183,7 @@ void UpdateLed::SendUpdate(const std::string &led_name, const std::string &led_s
     }
 
     SendMessage(message);
-    logger().Log("Sent update for LED " + led_name + " to state: " + led_state);
+    logger().Log(LogId::kUpdateSent, led_name, led_state);
 
     auto response_opt = ReceiveMessage();
     if (!response_opt) {
@@ -130,15 +197,112 @@ void UpdateLed::SendUpdate(const std::string &led_name, const std::string &led_s
         return;
     }
 
-    if (res.has_state_response()) {
-        const auto& state_res = res.state_response();
-        if (!state_res.error_message().empty()) {
-            std::cout << "Error from server: " << state_res.error_message() << std::endl;
-        } else {
-            std::cout << "Response: Led" << state_res.led_num() << " Updated" << std::endl;
+    PrintUpdateResponse(res);
+    LogStateResponse(logger(), res);
+}
+
+/** 
+ * @brief Sets a LED to a new state only if it has the expected one.
+ *
+ * The server compares and sets atomically, so two controllers racing for the
+ * same LED cannot both see their update succeed.
+ *
+ * @param led_id The id of the LED.
+ * @param expected The state the LED must have.
+ * @param desired The state to set.
+ * @return The server's answer, or nullopt if sending or receiving failed.
+ */
+std::optional<hello_ipc::CompareAndSetResponse> UpdateLed::CompareAndSet(uint32_t led_id, hello_ipc::LedState expected,
+                                                                         hello_ipc::LedState desired) {
+    hello_ipc::Request req;
+    auto *cas_req = req.mutable_compare_and_set_request();
+    cas_req->set_led_id(led_id);
+    cas_req->set_expected(expected);
+    cas_req->set_desired(desired);
+    req.set_request_id(next_request_id_++);
+
+    std::string message;
+    if (!req.SerializeToString(&message)) {
+        std::cerr << "Error: Failed to serialize request." << std::endl;
+        return std::nullopt;
+    }
+    SendMessage(message);
+
+    auto response_opt = ReceiveMessage();
+    if (!response_opt) {
+        std::cerr << "Error: Failed to receive response from server." << std::endl;
+        return std::nullopt;
+    }
+
+    hello_ipc::Response res;
+    if (!res.ParseFromString(*response_opt) || !res.has_compare_and_set_response()) {
+        std::cerr << "Error: Failed to parse response." << std::endl;
+        return std::nullopt;
+    }
+    return res.compare_and_set_response();
+}
+
+/** 
+ * @brief Sends updates for several LEDs without waiting for each response.
+ *
+ * Up to kMaxInFlight requests are written with a single gathered send, then their
+ * responses are collected and matched to the requests by request id.
+ *
+ * @param led_names The names of the LEDs to update.
+ * @param led_state The desired state of the LEDs ("on" or "off").
+ */
+void UpdateLed::SendUpdates(const std::vector<std::string> &led_names, const std::string &led_state) {
+    for (std::size_t first = 0; first < led_names.size(); first += kMaxInFlight) {
+        std::size_t last = std::min(led_names.size(), first + kMaxInFlight);
+
+        std::vector<std::string> messages;
+        std::deque<uint64_t> in_flight; // Request ids in send order
+        for (std::size_t i = first; i < last; ++i) {
+            hello_ipc::Request req;
+            auto* update_req = req.mutable_update_request();
+            SetLedId(update_req, led_names[i]);
+            update_req->set_state((led_state == "on") ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+            req.set_request_id(next_request_id_++);
+
+            std::string message;
+            if (!req.SerializeToString(&message)) {
+                std::cerr << "Error: Failed to serialize request." << std::endl;
+                return;
+            }
+            messages.push_back(std::move(message));
+            in_flight.push_back(req.request_id());
+        }
+
+        SendMessages(messages);
+        logger().Log(LogId::kUpdatesSent, messages.size(), led_state);
+
+        while (!in_flight.empty()) {
+            auto response_opt = ReceiveMessage();
+            if (!response_opt) {
+                std::cerr << "Error: Failed to receive response from server." << std::endl;
+                return;
+            }
+
+            hello_ipc::Response res;
+            if (!res.ParseFromString(*response_opt)) {
+                std::cerr << "Error: Failed to parse response." << std::endl;
+                return;
+            }
+
+            auto it = std::find(in_flight.begin(), in_flight.end(), res.request_id());
+            if (it == in_flight.end()) {
+                if (res.request_id() != 0) {
+                    logger().Log("Ignoring response for unknown request " + std::to_string(res.request_id()));
+                    continue;
+                }
+                it = in_flight.begin(); // Servers without request ids answer in order
+            }
+            in_flight.erase(it);
+
+            PrintUpdateResponse(res);
+            LogStateResponse(logger(), res);
         }
     }
-    logger().Log("Received response: " + res.DebugString());
 }
 
 } // namespace hello_ipc
\ No newline at end of file
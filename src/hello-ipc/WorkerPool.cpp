@@ -0,0 +1,96 @@
+#include "WorkerPool.hpp"
+
+namespace hello_ipc {
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param num_threads Number of workers; 0 means one per available core.
+ */
+WorkerPool::WorkerPool(std::size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+
+    workers_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (auto &worker : workers_) {
+        Worker *w = worker.get();
+        w->thread = std::thread([w]() { WorkerLoop(*w); });
+    }
+}
+
+/**
+ * @brief Drains the pending tasks and joins the worker threads.
+ */
+WorkerPool::~WorkerPool() {
+    for (auto &worker : workers_) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stopping = true;
+        }
+        worker->cv.notify_one();
+    }
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+/**
+ * @brief Queues a task on the worker selected by key.
+ *
+ * @param key Routing key, tasks with the same key run in submission order.
+ * @param task The work to run.
+ */
+void WorkerPool::Submit(std::size_t key, std::function<void()> task) {
+    Worker &worker = *workers_[key % workers_.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        auto &queue = worker.queues[key];
+        if (queue.empty()) {
+            worker.ready.push_back(key); // Not queued and not running, see WorkerLoop()
+        }
+        queue.push_back(std::move(task));
+    }
+    worker.cv.notify_one();
+}
+
+/**
+ * @brief Runs tasks from the worker's queues until the pool is stopped.
+ *
+ * Takes one task of the key at the front of the ready list and moves the key to the
+ * back if it has more. A key is in the ready list at most once, and not while its
+ * last task runs, so Submit() re-adds it only when its queue was empty.
+ *
+ * @param worker The worker whose queues are served.
+ */
+void WorkerPool::WorkerLoop(Worker &worker) {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.cv.wait(lock, [&worker]() { return worker.stopping || !worker.ready.empty(); });
+            if (worker.ready.empty()) {
+                return; // Stopping and nothing left to do
+            }
+            std::size_t key = worker.ready.front();
+            worker.ready.pop_front();
+            auto &queue = worker.queues[key];
+            task = std::move(queue.front());
+            queue.pop_front();
+            if (!queue.empty()) {
+                worker.ready.push_back(key);
+            }
+        }
+        task();
+    }
+}
+
+} // namespace hello_ipc
@@ -0,0 +1,79 @@
+#include "LogRecord.hpp"
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+/**
+ * @brief Formats a record timestamp as local time with microseconds.
+ */
+static std::string FormatTimestamp(uint64_t timestamp_ns) {
+    time_t seconds = static_cast<time_t>(timestamp_ns / 1000000000ULL);
+    struct tm local;
+    localtime_r(&seconds, &local);
+
+    char buffer[64];
+    std::size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(buffer + length, sizeof(buffer) - length, ".%06llu",
+             static_cast<unsigned long long>((timestamp_ns / 1000ULL) % 1000000ULL));
+    return buffer;
+}
+
+/**
+ * @brief Decodes a binary log written by a Logger in binary format back to text.
+ *
+ * Usage: hello_ipc_logdump /tmp/<service>.binlog
+ */
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.binlog>\n";
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << argv[1] << "\n";
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const std::size_t magic_size = sizeof(hello_ipc::kBinaryLogMagic);
+    uint16_t name_length;
+    if (data.size() < magic_size + sizeof(name_length) ||
+        memcmp(data.data(), hello_ipc::kBinaryLogMagic, magic_size) != 0) {
+        std::cerr << argv[1] << " is not a hello_ipc binary log\n";
+        return 1;
+    }
+    memcpy(&name_length, data.data() + magic_size, sizeof(name_length));
+    std::size_t pos = magic_size + sizeof(name_length);
+    if (pos + name_length > data.size()) {
+        std::cerr << "Truncated log header\n";
+        return 1;
+    }
+    const std::string prefix = "[" + data.substr(pos, name_length) + "]: ";
+    pos += name_length;
+
+    std::string line;
+    while (pos + sizeof(uint16_t) <= data.size()) {
+        uint16_t size;
+        memcpy(&size, data.data() + pos, sizeof(size));
+        pos += sizeof(size);
+        if (pos + size > data.size()) {
+            std::cerr << "Truncated record at offset " << pos << "\n";
+            return 1;
+        }
+
+        uint64_t timestamp_ns = 0;
+        line.clear();
+        if (!hello_ipc::FormatLogRecord(data.data() + pos, size, line, &timestamp_ns)) {
+            std::cerr << "Malformed record at offset " << pos << "\n";
+            return 1;
+        }
+        std::cout << FormatTimestamp(timestamp_ns) << " " << prefix << line << "\n";
+        pos += size;
+    }
+    return 0;
+}
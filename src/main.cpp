@@ -1,6 +1,11 @@
 #include "LedManager.hpp"
+#include "LoadGenerator.hpp"
 #include "UpdateLed.hpp"
 #include "QueryLed.hpp"
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -11,19 +16,56 @@
  */
 const std::string LED_MANAGER_SOCKET = "/tmp/led_manager.sock";
 
+// The running LedManager, stopped by SIGINT and SIGTERM so it can write its final state.
+hello_ipc::LedManager *running_server = nullptr;
+
+void StopServerOnSignal(int) {
+    if (running_server != nullptr) {
+        running_server->Stop();
+    }
+}
+
+// Parses a non-negative decimal int, with nothing after the digits.
+bool ParseCount(const char *text, int *value) {
+    char *end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || parsed < 0 || parsed > INT_MAX) {
+        return false;
+    }
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
 void PrintUsage() {
     std::cerr << "Usage: hello_ipc <mode> [options]\n"
               << "Modes:\n"
               << "  --led-manager    Run the LedManager server.\n"
+              << "                   [--io-uring]        serve clients with io_uring instead of epoll\n"
+              << "                   [--state-file PATH] restore and persist the LED table in PATH\n"
+              << "                   [--backlog N]       pending connections queued by the kernel (default 128)\n"
+              << "                   [--max-connections N] clients served at once, 0 is unlimited (default 0)\n"
+              << "                   [--max-in-flight N] queued requests per client before OVERLOADED, 0 is unlimited\n"
               << "  --update-led     Run the UpdateLed client.\n"
-              << "  --query-led      Run the QueryLed client.\n";
+              << "  --query-led      Run the QueryLed client.\n"
+              << "  --stats          Print the LedManager's runtime metrics.\n"
+              << "  --watch [LED...] Print every change of the given LEDs, or of all LEDs.\n"
+              << "  --load-gen       Drive the LedManager and report throughput and latency.\n"
+              << "                   [--connections N]   concurrent connections (default 4)\n"
+              << "                   [--update-ratio R]  fraction of updates, the rest are queries (default 0.5)\n"
+              << "                   [--keys K]          number of distinct LEDs (default 1024)\n"
+              << "                   [--zipf S]          Zipf skew of the LED choice, 0 is uniform (default 0)\n"
+              << "                   [--rate R]          open-loop requests per second, 0 is closed-loop (default 0)\n"
+              << "                   [--duration S]      seconds to run (default 10)\n"
+              << "                   [--compact]         use the fixed-size compact wire format\n";
 }
 
 /** 
  * @brief Main entry point for the hello-ipc application.
  *
  * This function initializes the application based on the provided mode.
- * It can run either the LedManager server, the UpdateLed client or the QueryLed client.
+ * It can run either the LedManager server, the UpdateLed client, the QueryLed client
+ * or the load generator.
  *
  * @param argc Argument count.
  * @param argv Argument vector.
@@ -40,13 +82,64 @@ int main(int argc, char* argv[]) {
     try {
         if (mode == "--led-manager") {
             hello_ipc::LedManager server;
+            hello_ipc::Service::ServerLimits limits;
+            int count;
+            for (int i = 2; i < argc; ++i) {
+                std::string option = argv[i];
+                if (option == "--io-uring") {
+                    server.SetServerBackend(hello_ipc::Service::ServerBackend::kIoUring);
+                } else if (option == "--state-file" && i + 1 < argc) {
+                    server.EnableStateStore(argv[++i]);
+                } else if (option == "--backlog" && i + 1 < argc && ParseCount(argv[i + 1], &count) && count > 0) {
+                    limits.backlog = count;
+                    ++i;
+                } else if (option == "--max-connections" && i + 1 < argc && ParseCount(argv[i + 1], &count)) {
+                    limits.max_connections = static_cast<std::size_t>(count);
+                    ++i;
+                } else if (option == "--max-in-flight" && i + 1 < argc && ParseCount(argv[i + 1], &count)) {
+                    limits.max_in_flight = count;
+                    ++i;
+                } else {
+                    PrintUsage();
+                    return 1;
+                }
+            }
+            server.SetServerLimits(limits);
+            running_server = &server;
+            std::signal(SIGINT, StopServerOnSignal);
+            std::signal(SIGTERM, StopServerOnSignal);
             server.Run(LED_MANAGER_SOCKET);
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            running_server = nullptr;
         } else if (mode == "--update-led") {
             hello_ipc::UpdateLed client(LED_MANAGER_SOCKET, argc, argv);
             client.Run();
         } else if (mode == "--query-led") {
             hello_ipc::QueryLed client(LED_MANAGER_SOCKET);
             client.Run();
+        } else if (mode == "--stats") {
+            hello_ipc::QueryLed client(LED_MANAGER_SOCKET);
+            if (!client.QueryStats(std::cout)) {
+                return 1;
+            }
+        } else if (mode == "--watch") {
+            hello_ipc::QueryLed client(LED_MANAGER_SOCKET);
+            if (!client.Watch(std::vector<std::string>(argv + 2, argv + argc), std::cout)) {
+                return 1;
+            }
+        } else if (mode == "--load-gen") {
+            hello_ipc::LoadGenerator::Options options;
+            if (!hello_ipc::LoadGenerator::ParseArguments(argc, argv, &options)) {
+                PrintUsage();
+                return 1;
+            }
+            hello_ipc::LoadGenerator generator(LED_MANAGER_SOCKET, options);
+            if (!generator.Run()) {
+                std::cerr << "Failed to connect to the LedManager." << std::endl;
+                return 1;
+            }
+            generator.PrintReport(std::cout);
         } else {
             PrintUsage();
             return 1;
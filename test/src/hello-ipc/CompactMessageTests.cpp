@@ -0,0 +1,58 @@
+#include "CompactMessage.hpp"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for the compact wire format ---
+
+TEST(CompactMessageTest, EncodeDecodeRoundTrip) {
+    hello_ipc::CompactMessage message;
+    message.opcode = hello_ipc::CompactOpcode::kUpdate;
+    message.on = true;
+    message.led_id = 0x01020304;
+    message.request_id = 0x1122334455667788ULL;
+
+    std::string data(hello_ipc::kCompactMessageSize, '\0');
+    hello_ipc::EncodeCompactMessage(message, &data[0]);
+
+    hello_ipc::CompactMessage decoded;
+    ASSERT_TRUE(hello_ipc::DecodeCompactMessage(data, &decoded));
+    EXPECT_EQ(decoded.opcode, hello_ipc::CompactOpcode::kUpdate);
+    EXPECT_TRUE(decoded.on);
+    EXPECT_EQ(decoded.error, hello_ipc::CompactError::kNone);
+    EXPECT_EQ(decoded.led_id, 0x01020304u);
+    EXPECT_EQ(decoded.request_id, 0x1122334455667788ULL);
+}
+
+TEST(CompactMessageTest, EncodesIntegersInNetworkByteOrder) {
+    hello_ipc::CompactMessage message;
+    message.opcode = hello_ipc::CompactOpcode::kError;
+    message.error = hello_ipc::CompactError::kNotFound;
+    message.led_id = 7;
+    message.request_id = 9;
+
+    std::string data(hello_ipc::kCompactMessageSize, '\0');
+    hello_ipc::EncodeCompactMessage(message, &data[0]);
+
+    EXPECT_EQ(data, std::string("\x04\x00\x01\x00\x00\x00\x00\x07\x00\x00\x00\x00\x00\x00\x00\x09", 16));
+}
+
+TEST(CompactMessageTest, DecodeRejectsMalformedMessages) {
+    hello_ipc::CompactMessage message;
+    std::string data(hello_ipc::kCompactMessageSize, '\0');
+    hello_ipc::EncodeCompactMessage(message, &data[0]);
+
+    EXPECT_FALSE(hello_ipc::DecodeCompactMessage(data.substr(1), &message));
+    EXPECT_FALSE(hello_ipc::DecodeCompactMessage(data + "x", &message));
+
+    data[0] = 0;
+    EXPECT_FALSE(hello_ipc::DecodeCompactMessage(data, &message));
+    data[0] = 5;
+    EXPECT_FALSE(hello_ipc::DecodeCompactMessage(data, &message));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.hpp"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for LatencyHistogram ---
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    hello_ipc::LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.Percentile(50), 0u);
+    EXPECT_EQ(histogram.min(), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    hello_ipc::LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value) {
+        histogram.Record(value);
+    }
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.Percentile(50), 50u);
+    EXPECT_EQ(histogram.Percentile(99), 99u);
+    EXPECT_EQ(histogram.Percentile(100), 100u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50.5);
+}
+
+TEST(LatencyHistogramTest, LargeValuesStayWithinOnePercent) {
+    const uint64_t values[] = {1000, 123456, 987654321, 1ULL << 40, UINT64_MAX / 3};
+    for (uint64_t value : values) {
+        hello_ipc::LatencyHistogram histogram;
+        histogram.Record(value / 2);
+        histogram.Record(value);
+        histogram.Record(value * 2 > value ? value * 2 : UINT64_MAX);
+
+        uint64_t median = histogram.Percentile(50);
+        EXPECT_GE(median, value);
+        EXPECT_LE(static_cast<double>(median - value), static_cast<double>(value) * 0.01) << value;
+    }
+}
+
+TEST(LatencyHistogramTest, TailPercentilesFollowTheOutliers) {
+    hello_ipc::LatencyHistogram histogram;
+    for (int i = 0; i < 999; ++i) {
+        histogram.Record(10000);
+    }
+    histogram.Record(5000000);
+
+    EXPECT_LE(histogram.Percentile(99), 10100u);
+    EXPECT_EQ(histogram.Percentile(100), 5000000u);
+    EXPECT_EQ(histogram.max(), 5000000u);
+}
+
+TEST(LatencyHistogramTest, MergeAddsCountsAndKeepsExtremes) {
+    hello_ipc::LatencyHistogram first;
+    hello_ipc::LatencyHistogram second;
+    first.Record(10);
+    first.Record(20);
+    second.Record(5);
+    second.Record(40);
+
+    first.Merge(second);
+    EXPECT_EQ(first.count(), 4u);
+    EXPECT_EQ(first.min(), 5u);
+    EXPECT_EQ(first.max(), 40u);
+    EXPECT_EQ(first.Percentile(50), 10u);
+
+    first.Reset();
+    EXPECT_EQ(first.count(), 0u);
+    EXPECT_EQ(first.max(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+#include "LedFileCache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+class LedFileCacheTest : public ::testing::Test {
+protected:
+    std::string root = "/tmp/hello_ipc_led_file_cache_test";
+
+    void SetUp() override {
+        std::filesystem::remove_all(root);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::string ReadFile(uint32_t led_id) {
+        std::ifstream file(root + "/led_" + std::to_string(led_id) + "/brightness");
+        std::string content;
+        std::getline(file, content);
+        return content;
+    }
+};
+
+TEST_F(LedFileCacheTest, WriteCreatesFileAndReadReturnsIt) {
+    hello_ipc::LedFileCache cache(4, root);
+
+    ASSERT_TRUE(cache.Write(7, '1'));
+    EXPECT_EQ(ReadFile(7), "1");
+
+    char value = 0;
+    ASSERT_TRUE(cache.Read(7, &value));
+    EXPECT_EQ(value, '1');
+
+    ASSERT_TRUE(cache.Write(7, '0'));
+    EXPECT_EQ(ReadFile(7), "0");
+    ASSERT_TRUE(cache.Read(7, &value));
+    EXPECT_EQ(value, '0');
+}
+
+TEST_F(LedFileCacheTest, ReadOfMissingLedFailsWithoutCreatingIt) {
+    hello_ipc::LedFileCache cache(4, root);
+
+    char value;
+    EXPECT_FALSE(cache.Read(3, &value));
+    EXPECT_FALSE(std::filesystem::exists(root + "/led_3"));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST_F(LedFileCacheTest, EvictsLeastRecentlyUsedBeyondCapacity) {
+    hello_ipc::LedFileCache cache(2, root);
+
+    ASSERT_TRUE(cache.Write(1, '1'));
+    ASSERT_TRUE(cache.Write(2, '1'));
+    ASSERT_TRUE(cache.Write(3, '0'));
+    EXPECT_EQ(cache.size(), 2u);
+
+    // Evicted LEDs are simply reopened
+    char value = 0;
+    ASSERT_TRUE(cache.Read(1, &value));
+    EXPECT_EQ(value, '1');
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST_F(LedFileCacheTest, ReopensFileAfterDirectoryIsRemoved) {
+    hello_ipc::LedFileCache cache(4, root, std::chrono::milliseconds(10));
+    ASSERT_TRUE(cache.Write(5, '1'));
+
+    // The unlinked file is noticed by the next check, not on every access
+    std::filesystem::remove_all(root);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    char value;
+    EXPECT_FALSE(cache.Read(5, &value));
+    EXPECT_EQ(cache.size(), 0u);
+
+    ASSERT_TRUE(cache.Write(5, '0'));
+    EXPECT_EQ(ReadFile(5), "0");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
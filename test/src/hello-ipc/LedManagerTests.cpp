@@ -1,8 +1,21 @@
 #include "LedManager.hpp"
+#include "LedStateStore.hpp"
+#include "QueryLed.hpp"
 #include "led_service.pb.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
@@ -10,15 +23,33 @@
 class TestableLedManager : public hello_ipc::LedManager {
 public:
     // Expose the private handler methods for direct testing
+    using hello_ipc::LedManager::HandleMessage;
     using hello_ipc::LedManager::HandleUpdateRequest;
     using hello_ipc::LedManager::HandleQueryRequest;
+    using hello_ipc::LedManager::HandleBatchUpdateRequest;
+    using hello_ipc::LedManager::HandleBatchQueryRequest;
+    using hello_ipc::LedManager::HandleStatsRequest;
+    using hello_ipc::LedManager::HandleSubscribeRequest;
+    using hello_ipc::LedManager::HandleCompareAndSetRequest;
+    using hello_ipc::LedManager::OverloadedResponse;
+    using hello_ipc::LedManager::ClassifyMessage;
+    using hello_ipc::LedManager::metrics;
     using hello_ipc::LedManager::UpdateLedState;
+    using hello_ipc::LedManager::StoreLedState;
     using hello_ipc::LedManager::GetLedState;
+    using hello_ipc::LedManager::StopServer;
+};
+
+// Client that can retry connecting while the server thread starts up
+class TestableQueryLed : public hello_ipc::QueryLed {
+public:
+    TestableQueryLed() : hello_ipc::QueryLed("", false) {}
+    using hello_ipc::QueryLed::ConnectToServer;
 };
 
 class LedManagerTest : public ::testing::Test {
 protected:
-    std::string led_name = "999_test";
+    std::string led_name = "999";
     std::string ledDir = "/tmp/sys/class/led_" + led_name;
     std::string filePath = ledDir + "/brightness";
     TestableLedManager manager;
@@ -38,17 +69,20 @@ protected:
 
 TEST_F(LedManagerTest, UpdateLedStateReturnsTrueOnSuccess) {
     EXPECT_TRUE(manager.UpdateLedState(led_name, hello_ipc::LedState::ON));
+    manager.Flush();
     EXPECT_TRUE(std::filesystem::exists(filePath));
 }
 
 TEST_F(LedManagerTest, UpdateLedStateSetsCorrectState) {
     manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+    manager.Flush();
     std::ifstream file_on(filePath);
     std::string content_on;
     std::getline(file_on, content_on);
     EXPECT_EQ(content_on, "1");
 
     manager.UpdateLedState(led_name, hello_ipc::LedState::OFF);
+    manager.Flush();
     std::ifstream file_off(filePath);
     std::string content_off;
     std::getline(file_off, content_off);
@@ -58,6 +92,7 @@ TEST_F(LedManagerTest, UpdateLedStateSetsCorrectState) {
 TEST_F(LedManagerTest, UpdateLedStateReturnsFalseForInvalidState) {
     // Test with an enum value that is not ON or OFF
     EXPECT_FALSE(manager.UpdateLedState(led_name, static_cast<hello_ipc::LedState>(123)));
+    manager.Flush();
     EXPECT_FALSE(std::filesystem::exists(filePath));
 }
 
@@ -65,20 +100,85 @@ TEST_F(LedManagerTest, UpdateLedStateReturnsFalseForEmptyLedName) {
     EXPECT_FALSE(manager.UpdateLedState("", hello_ipc::LedState::ON));
 }
 
+TEST_F(LedManagerTest, UpdateLedStateReturnsFalseForNonNumericLedName) {
+    EXPECT_FALSE(manager.UpdateLedState("999_test", hello_ipc::LedState::ON));
+    EXPECT_FALSE(manager.UpdateLedState("-1", hello_ipc::LedState::ON));
+}
+
+TEST_F(LedManagerTest, UpdateLedStateIsVisibleBeforeFlush) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+    EXPECT_EQ(manager.GetLedState(led_name), "on");
+}
+
+TEST_F(LedManagerTest, FlushWritesLatestOfRepeatedUpdates) {
+    for (int i = 0; i < 10; ++i) {
+        manager.UpdateLedState(led_name, (i % 2 == 0) ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+    }
+    manager.Flush();
+
+    std::ifstream file(filePath);
+    std::string content;
+    std::getline(file, content);
+    EXPECT_EQ(content, "0");
+}
+
+TEST_F(LedManagerTest, UpdateToCurrentStateIsNotWritten) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+    manager.Flush();
+    std::fstream(filePath, std::ios::in | std::ios::out) << "x"; // Marks the file in place
+
+    // Still reported as a success, but the file is not written again
+    auto content = [this]() {
+        std::ifstream file(filePath);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    };
+    EXPECT_TRUE(manager.UpdateLedState(led_name, hello_ipc::LedState::ON));
+    manager.Flush();
+    EXPECT_EQ(content(), "x");
+    EXPECT_EQ(manager.metrics().Read().counters[hello_ipc::Metrics::kNoOpUpdates], 1u);
+
+    EXPECT_TRUE(manager.UpdateLedState(led_name, hello_ipc::LedState::OFF));
+    manager.Flush();
+    EXPECT_EQ(content(), "0");
+    EXPECT_EQ(manager.metrics().Read().counters[hello_ipc::Metrics::kNoOpUpdates], 1u);
+}
+
+TEST_F(LedManagerTest, StoreLedStateReportsWhetherTheStateChanged) {
+    bool changed = false;
+    EXPECT_TRUE(manager.StoreLedState(led_name, hello_ipc::LedState::ON, &changed));
+    EXPECT_TRUE(changed);
+    EXPECT_TRUE(manager.StoreLedState(led_name, hello_ipc::LedState::ON, &changed));
+    EXPECT_FALSE(changed);
+    EXPECT_TRUE(manager.StoreLedState(999u, hello_ipc::LedState::OFF, &changed));
+    EXPECT_TRUE(changed);
+}
+
 // --- Tests for GetLedState ---
 
-TEST_F(LedManagerTest, GetLedStateReturnsCorrectState) {
+TEST_F(LedManagerTest, GetLedStateLoadsStateFromFile) {
     std::filesystem::create_directories(ledDir);
     
     std::ofstream file_on(filePath);
     file_on << "1";
     file_on.close();
     EXPECT_EQ(manager.GetLedState(led_name), "on");
+}
+
+TEST_F(LedManagerTest, GetLedStateIsServedFromTableAfterLoad) {
+    std::filesystem::create_directories(ledDir);
 
     std::ofstream file_off(filePath);
     file_off << "0";
     file_off.close();
     EXPECT_EQ(manager.GetLedState(led_name), "off");
+
+    // The table is authoritative once loaded, outside writes are not seen
+    std::ofstream file_on(filePath);
+    file_on << "1";
+    file_on.close();
+    EXPECT_EQ(manager.GetLedState(led_name), "off");
 }
 
 TEST_F(LedManagerTest, GetLedStateReturnsErrorWhenNotFound) {
@@ -98,6 +198,7 @@ TEST_F(LedManagerTest, HandleUpdateRequestCorrectlyUpdatesState) {
 
     hello_ipc::LedStateResponse res;
     manager.HandleUpdateRequest(req, &res);
+    manager.Flush();
 
     // Check that the file system was updated
     EXPECT_TRUE(std::filesystem::exists(filePath));
@@ -153,6 +254,584 @@ TEST_F(LedManagerTest, HandleQueryRequestHandlesNotFound) {
     EXPECT_EQ(res.error_message(), "error: LED not found");
 }
 
+TEST_F(LedManagerTest, HandleUpdateRequestPrefersLedId) {
+    hello_ipc::LedUpdateRequest req;
+    req.set_led_id(999);
+    req.set_led_num("not_a_number"); // Ignored when led_id is set
+    req.set_state(hello_ipc::LedState::ON);
+
+    hello_ipc::LedStateResponse res;
+    manager.HandleUpdateRequest(req, &res);
+
+    EXPECT_TRUE(res.error_message().empty());
+    EXPECT_TRUE(res.has_led_id());
+    EXPECT_EQ(res.led_id(), 999u);
+    EXPECT_EQ(manager.GetLedState(led_name), "on");
+    manager.Flush();
+}
+
+TEST_F(LedManagerTest, HandleQueryRequestEchoesOnlyLedId) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+
+    hello_ipc::LedQueryRequest req;
+    req.set_led_id(999);
+
+    hello_ipc::LedStateResponse res;
+    manager.HandleQueryRequest(req, &res);
+
+    EXPECT_EQ(res.led_id(), 999u);
+    EXPECT_TRUE(res.led_num().empty());
+    EXPECT_EQ(res.state(), hello_ipc::LedState::ON);
+
+    req.set_led_id(12345); // No brightness file
+    hello_ipc::LedStateResponse missing_res;
+    manager.HandleQueryRequest(req, &missing_res);
+    EXPECT_EQ(missing_res.error_message(), "error: LED not found");
+}
+
+TEST_F(LedManagerTest, StateStoreRestoresTableAfterRestart) {
+    const std::string state_file = "/tmp/hello_ipc_led_manager_test.leds";
+    std::filesystem::remove(state_file);
+    std::filesystem::remove(state_file + ".journal");
+    {
+        TestableLedManager first;
+        ASSERT_TRUE(first.EnableStateStore(state_file));
+        first.UpdateLedState(led_name, hello_ipc::LedState::ON);
+        first.Flush(); // Journals the update
+    }
+
+    // Without its brightness file the LED is only known from the store
+    std::filesystem::remove_all(ledDir);
+    TestableLedManager restarted;
+    EXPECT_EQ(restarted.GetLedState(led_name), "error: LED not found");
+    ASSERT_TRUE(manager.EnableStateStore(state_file));
+    EXPECT_EQ(manager.GetLedState(led_name), "on");
+
+    // The journaled change may never have reached the LED, so it is written again
+    manager.Flush();
+    std::ifstream file(filePath);
+    std::string content;
+    std::getline(file, content);
+    EXPECT_EQ(content, "1");
+
+    std::filesystem::remove(state_file);
+    std::filesystem::remove(state_file + ".journal");
+}
+
+TEST_F(LedManagerTest, CheckpointLeavesOutStatesNotWrittenYet) {
+    const std::string state_file = "/tmp/hello_ipc_led_manager_test.leds";
+    const std::string crash_file = "/tmp/hello_ipc_led_manager_test_crash.leds";
+    for (const auto &path : {state_file, crash_file}) {
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".journal");
+    }
+    ASSERT_TRUE(manager.EnableStateStore(state_file));
+    manager.UpdateLedState(led_name, hello_ipc::LedState::OFF);
+    manager.Flush();
+
+    // Checkpoint while the flusher still holds the update back, then "crash"
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+    manager.Checkpoint();
+    std::filesystem::copy_file(state_file, crash_file);
+    std::ifstream file(filePath);
+    std::string content;
+    std::getline(file, content);
+
+    std::optional<hello_ipc::LedState> snapshot_state;
+    hello_ipc::LedStateStore store(crash_file);
+    std::string error;
+    ASSERT_TRUE(store.Open([&](uint32_t led_id, hello_ipc::LedState led_state, bool journaled) {
+        if (led_id == 999 && !journaled) {
+            snapshot_state = led_state;
+        }
+    }, &error)) << error;
+
+    // The snapshot never claims a state the brightness file did not have yet
+    if (content == "0") {
+        EXPECT_NE(snapshot_state, std::optional<hello_ipc::LedState>(hello_ipc::LedState::ON));
+    }
+
+    manager.Flush();
+    for (const auto &path : {state_file, crash_file}) {
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".journal");
+    }
+}
+
+TEST_F(LedManagerTest, HandleBatchUpdateRequestUpdatesEveryLed) {
+    const std::string other_led = "998";
+    hello_ipc::BatchUpdateRequest req;
+    auto *first = req.add_updates();
+    first->set_led_num(led_name);
+    first->set_state(hello_ipc::LedState::ON);
+    auto *second = req.add_updates();
+    second->set_led_num(other_led);
+    second->set_state(hello_ipc::LedState::OFF);
+    req.add_updates()->set_led_num(""); // Invalid, must not fail the rest of the batch
+
+    hello_ipc::BatchStateResponse res;
+    manager.HandleBatchUpdateRequest(req, &res);
+
+    ASSERT_EQ(res.states_size(), 3);
+    EXPECT_EQ(res.states(0).led_num(), led_name);
+    EXPECT_EQ(res.states(0).state(), hello_ipc::LedState::ON);
+    EXPECT_TRUE(res.states(0).error_message().empty());
+    EXPECT_EQ(res.states(1).led_num(), other_led);
+    EXPECT_EQ(res.states(1).state(), hello_ipc::LedState::OFF);
+    EXPECT_FALSE(res.states(2).error_message().empty());
+
+    EXPECT_EQ(manager.GetLedState(led_name), "on");
+    EXPECT_EQ(manager.GetLedState(other_led), "off");
+    manager.Flush();
+    std::filesystem::remove_all("/tmp/sys/class/led_" + other_led);
+}
+
+TEST_F(LedManagerTest, HandleBatchQueryRequestReturnsStatesInRequestOrder) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+
+    hello_ipc::BatchQueryRequest req;
+    req.add_queries()->set_led_num("non_existent_led");
+    req.add_queries()->set_led_num(led_name);
+
+    hello_ipc::BatchStateResponse res;
+    manager.HandleBatchQueryRequest(req, &res);
+
+    ASSERT_EQ(res.states_size(), 2);
+    EXPECT_EQ(res.states(0).led_num(), "non_existent_led");
+    EXPECT_EQ(res.states(0).error_message(), "error: LED not found");
+    EXPECT_EQ(res.states(1).led_num(), led_name);
+    EXPECT_EQ(res.states(1).state(), hello_ipc::LedState::ON);
+    EXPECT_TRUE(res.states(1).error_message().empty());
+}
+
+TEST_F(LedManagerTest, HandleCompareAndSetRequestSwapsOnlyExpectedState) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::OFF);
+
+    hello_ipc::CompareAndSetRequest req;
+    req.set_led_id(999);
+    req.set_expected(hello_ipc::LedState::ON);
+    req.set_desired(hello_ipc::LedState::OFF);
+
+    hello_ipc::CompareAndSetResponse res;
+    manager.HandleCompareAndSetRequest(req, &res);
+    EXPECT_FALSE(res.swapped());
+    EXPECT_EQ(res.observed(), hello_ipc::LedState::OFF);
+    EXPECT_TRUE(res.error_message().empty());
+
+    req.set_expected(hello_ipc::LedState::OFF);
+    req.set_desired(hello_ipc::LedState::ON);
+    hello_ipc::CompareAndSetResponse swapped_res;
+    manager.HandleCompareAndSetRequest(req, &swapped_res);
+    EXPECT_TRUE(swapped_res.swapped());
+    EXPECT_EQ(swapped_res.observed(), hello_ipc::LedState::OFF);
+    EXPECT_EQ(swapped_res.led_id(), 999u);
+    EXPECT_EQ(manager.GetLedState(led_name), "on");
+
+    manager.Flush();
+    std::ifstream file(filePath);
+    std::string content;
+    std::getline(file, content);
+    EXPECT_EQ(content, "1");
+}
+
+TEST_F(LedManagerTest, CompareAndSetToTheCurrentStateIsANoOp) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::ON);
+    manager.Flush();
+    std::fstream(filePath, std::ios::in | std::ios::out) << "x"; // Marks the file in place
+
+    hello_ipc::CompareAndSetRequest req;
+    req.set_led_id(999);
+    req.set_expected(hello_ipc::LedState::ON);
+    req.set_desired(hello_ipc::LedState::ON);
+    hello_ipc::CompareAndSetResponse res;
+    manager.HandleCompareAndSetRequest(req, &res);
+    EXPECT_TRUE(res.swapped());
+    EXPECT_EQ(res.observed(), hello_ipc::LedState::ON);
+    EXPECT_EQ(manager.metrics().Read().counters[hello_ipc::Metrics::kNoOpUpdates], 1u);
+
+    // Nothing changed, so nothing is written
+    manager.Flush();
+    std::ifstream file(filePath);
+    std::string content;
+    std::getline(file, content);
+    EXPECT_EQ(content, "x");
+}
+
+TEST_F(LedManagerTest, HandleCompareAndSetRequestRejectsUnknownLedAndInvalidState) {
+    hello_ipc::CompareAndSetRequest req;
+    req.set_led_id(12345); // No brightness file
+    req.set_expected(hello_ipc::LedState::OFF);
+    req.set_desired(hello_ipc::LedState::ON);
+
+    hello_ipc::CompareAndSetResponse res;
+    manager.HandleCompareAndSetRequest(req, &res);
+    EXPECT_EQ(res.error_message(), "error: LED not found");
+    EXPECT_FALSE(res.swapped());
+
+    req.set_led_id(999);
+    req.set_desired(static_cast<hello_ipc::LedState>(7));
+    hello_ipc::CompareAndSetResponse invalid_res;
+    manager.HandleCompareAndSetRequest(req, &invalid_res);
+    EXPECT_FALSE(invalid_res.error_message().empty());
+    EXPECT_FALSE(invalid_res.swapped());
+}
+
+TEST_F(LedManagerTest, ConcurrentCompareAndSetHasOneWinner) {
+    manager.UpdateLedState(led_name, hello_ipc::LedState::OFF);
+
+    hello_ipc::CompareAndSetRequest req;
+    req.set_led_id(999);
+    req.set_expected(hello_ipc::LedState::OFF);
+    req.set_desired(hello_ipc::LedState::ON);
+
+    std::atomic<int> winners{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([this, &req, &winners]() {
+            hello_ipc::CompareAndSetResponse res;
+            manager.HandleCompareAndSetRequest(req, &res);
+            if (res.swapped()) {
+                ++winners;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(winners.load(), 1);
+    manager.Flush();
+}
+
+TEST_F(LedManagerTest, HandleStatsRequestReportsCountersAndStages) {
+    manager.metrics().Add(hello_ipc::Metrics::kUpdateRequests, 3);
+    manager.metrics().Add(hello_ipc::Metrics::kBytesOut, 42);
+    manager.metrics().Add(hello_ipc::Metrics::kNoOpUpdates, 2);
+    manager.metrics().RecordLatency(hello_ipc::Metrics::kHandle, 1500);
+
+    hello_ipc::StatsResponse res;
+    manager.HandleStatsRequest(hello_ipc::StatsRequest(), &res);
+
+    EXPECT_EQ(res.update_requests(), 3u);
+    EXPECT_EQ(res.query_requests(), 0u);
+    EXPECT_EQ(res.bytes_out(), 42u);
+    EXPECT_EQ(res.noop_updates(), 2u);
+    ASSERT_EQ(res.stages_size(), hello_ipc::Metrics::kStageCount);
+    const auto &handle = res.stages(hello_ipc::Metrics::kHandle);
+    EXPECT_EQ(handle.stage(), "handle");
+    EXPECT_EQ(handle.count(), 1u);
+    EXPECT_EQ(handle.max_ns(), 1500u);
+    EXPECT_GE(handle.p50_ns(), 1500u);
+}
+
+// --- Tests for HandleMessage ---
+
+// Reads one length-prefixed response from the test end of a socket pair.
+static hello_ipc::Response ReadResponse(int fd) {
+    uint32_t msg_size = 0;
+    EXPECT_EQ(recv(fd, &msg_size, sizeof(msg_size), MSG_WAITALL), static_cast<ssize_t>(sizeof(msg_size)));
+    std::string body(ntohl(msg_size), '\0');
+    EXPECT_EQ(recv(fd, body.data(), body.size(), MSG_WAITALL), static_cast<ssize_t>(body.size()));
+    hello_ipc::Response res;
+    EXPECT_TRUE(res.ParseFromString(body));
+    return res;
+}
+
+TEST_F(LedManagerTest, HandleMessageReusesBuffersAcrossRequests) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    hello_ipc::Request update;
+    update.set_request_id(1);
+    update.mutable_update_request()->set_led_num(led_name);
+    update.mutable_update_request()->set_state(hello_ipc::LedState::ON);
+    manager.HandleMessage(fds[0], update.SerializeAsString());
+
+    hello_ipc::Request batch;
+    batch.set_request_id(2);
+    for (int i = 0; i < 3; ++i) {
+        batch.mutable_batch_query_request()->add_queries()->set_led_num(led_name);
+    }
+    manager.HandleMessage(fds[0], batch.SerializeAsString());
+
+    hello_ipc::Request query;
+    query.set_request_id(3);
+    query.mutable_query_request()->set_led_num(led_name);
+    manager.HandleMessage(fds[0], query.SerializeAsString());
+
+    hello_ipc::Response res = ReadResponse(fds[1]);
+    EXPECT_EQ(res.request_id(), 1u);
+    EXPECT_EQ(res.state_response().state(), hello_ipc::LedState::ON);
+
+    res = ReadResponse(fds[1]);
+    EXPECT_EQ(res.request_id(), 2u);
+    EXPECT_EQ(res.batch_state_response().states_size(), 3);
+
+    // A shorter response after a longer one must not carry stale bytes
+    res = ReadResponse(fds[1]);
+    EXPECT_EQ(res.request_id(), 3u);
+    EXPECT_EQ(res.response_type_case(), hello_ipc::Response::kStateResponse);
+    EXPECT_EQ(res.state_response().led_num(), led_name);
+    EXPECT_EQ(res.state_response().state(), hello_ipc::LedState::ON);
+
+    manager.Flush();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_F(LedManagerTest, HandleMessageDropsUnparsableRequests) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    manager.HandleMessage(fds[0], std::string("\xff\xff\xff", 3));
+    EXPECT_EQ(manager.metrics().Read().counters[hello_ipc::Metrics::kParseFailures], 1u);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_F(LedManagerTest, OverloadedResponseAnswersWithoutHandlingTheRequest) {
+    hello_ipc::Request update;
+    update.set_request_id(7);
+    update.mutable_update_request()->set_led_num(led_name);
+    update.mutable_update_request()->set_state(hello_ipc::LedState::ON);
+    std::optional<std::string> response =
+        manager.OverloadedResponse(update.SerializeAsString(), hello_ipc::Service::WireFormat::kProtobuf);
+    ASSERT_TRUE(response.has_value());
+
+    hello_ipc::Response res;
+    ASSERT_TRUE(res.ParseFromString(*response));
+    EXPECT_EQ(res.request_id(), 7u);
+    EXPECT_EQ(res.state_response().code(), hello_ipc::ResponseCode::OVERLOADED);
+    EXPECT_FALSE(res.state_response().error_message().empty());
+    EXPECT_EQ(manager.GetLedState(led_name), "error: LED not found");
+    EXPECT_EQ(manager.metrics().Read().counters[hello_ipc::Metrics::kUpdateRequests], 0u);
+
+    EXPECT_FALSE(manager.OverloadedResponse("\xff\xff", hello_ipc::Service::WireFormat::kCompact).has_value());
+}
+
+TEST_F(LedManagerTest, ClassifyMessageSeparatesQueriesFromUpdates) {
+    using Lane = hello_ipc::Service::Lane;
+    const auto protobuf = hello_ipc::Service::WireFormat::kProtobuf;
+
+    hello_ipc::Request update;
+    update.set_request_id(1);
+    update.mutable_update_request()->set_led_id(5);
+    update.mutable_update_request()->set_state(hello_ipc::LedState::ON);
+    EXPECT_EQ(manager.ClassifyMessage(update.SerializeAsString(), protobuf), Lane::kBulk);
+
+    hello_ipc::Request query;
+    query.set_request_id(2);
+    query.mutable_query_request()->set_led_id(5);
+    EXPECT_EQ(manager.ClassifyMessage(query.SerializeAsString(), protobuf), Lane::kInteractive);
+
+    hello_ipc::Request batch_query;
+    batch_query.mutable_batch_query_request()->add_queries()->set_led_id(5);
+    EXPECT_EQ(manager.ClassifyMessage(batch_query.SerializeAsString(), protobuf), Lane::kInteractive);
+
+    // The priority field overrides the request type
+    update.set_priority(hello_ipc::PRIORITY_INTERACTIVE);
+    EXPECT_EQ(manager.ClassifyMessage(update.SerializeAsString(), protobuf), Lane::kInteractive);
+    query.set_priority(hello_ipc::PRIORITY_BULK);
+    EXPECT_EQ(manager.ClassifyMessage(query.SerializeAsString(), protobuf), Lane::kBulk);
+
+    EXPECT_EQ(manager.ClassifyMessage(std::string("\xff\xff\xff", 3), protobuf), Lane::kBulk);
+
+    // Unknown fixed-size fields are skipped, a truncated nested message makes the request bulk
+    query.clear_priority();
+    std::string with_unknown = query.SerializeAsString() + std::string("\x79" "12345678" "\x7d" "1234", 14);
+    EXPECT_EQ(manager.ClassifyMessage(with_unknown, protobuf), Lane::kInteractive);
+    std::string truncated = query.SerializeAsString();
+    truncated.pop_back();
+    EXPECT_EQ(manager.ClassifyMessage(truncated, protobuf), Lane::kBulk);
+
+    hello_ipc::CompactMessage compact;
+    compact.opcode = hello_ipc::CompactOpcode::kQuery;
+    std::string encoded(hello_ipc::kCompactMessageSize, '\0');
+    hello_ipc::EncodeCompactMessage(compact, encoded.data());
+    EXPECT_EQ(manager.ClassifyMessage(encoded, hello_ipc::Service::WireFormat::kCompact), Lane::kInteractive);
+    compact.opcode = hello_ipc::CompactOpcode::kUpdate;
+    hello_ipc::EncodeCompactMessage(compact, encoded.data());
+    EXPECT_EQ(manager.ClassifyMessage(encoded, hello_ipc::Service::WireFormat::kCompact), Lane::kBulk);
+}
+
+// --- Tests for subscriptions ---
+
+TEST(LedManagerSubscribeTest, PushesOnlyMatchingChangesToSubscribers) {
+    const std::string socket_path = "/tmp/hello_ipc_led_manager_test.sock";
+    TestableLedManager manager;
+    std::thread server_thread([&manager, &socket_path]() { manager.Run(socket_path); });
+
+    TestableQueryLed watcher;
+    bool connected = false;
+    for (int attempt = 0; attempt < 100 && !connected; ++attempt) {
+        connected = watcher.ConnectToServer(socket_path);
+        if (!connected) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_TRUE(connected);
+
+    std::ostringstream out;
+    std::atomic<bool> done(false);
+    bool watched = false;
+    std::thread watch_thread([&]() {
+        watched = watcher.Watch({"997"}, out, 2);
+        done = true;
+    });
+
+    // Keep changing both LEDs until the watcher has seen two changes of its own
+    bool on = false;
+    for (int i = 0; i < 500 && !done; ++i) {
+        on = !on;
+        manager.UpdateLedState("996", on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+        manager.UpdateLedState("997", on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    watch_thread.join();
+    EXPECT_TRUE(watched);
+    EXPECT_EQ(out.str().find("Led996"), std::string::npos);
+    EXPECT_NE(out.str().find("Led997="), std::string::npos);
+    EXPECT_GE(manager.metrics().Read().counters[hello_ipc::Metrics::kNotificationsSent], 2u);
+
+    manager.StopServer();
+    server_thread.join();
+    std::filesystem::remove_all("/tmp/sys/class/led_996");
+    std::filesystem::remove_all("/tmp/sys/class/led_997");
+}
+
+TEST(LedManagerSubscribeTest, SubscriberThatDoesNotReadDoesNotHoldUpOthers) {
+    const std::string socket_path = "/tmp/hello_ipc_led_manager_test.sock";
+    auto manager = std::make_unique<TestableLedManager>();
+    std::thread server_thread([&manager, &socket_path]() { manager->Run(socket_path); });
+
+    auto connect = [&socket_path](TestableQueryLed &client) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            if (client.ConnectToServer(socket_path)) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    // Subscribes to every LED and never reads a notification
+    TestableQueryLed stalled;
+    ASSERT_TRUE(connect(stalled));
+    hello_ipc::Request subscribe;
+    subscribe.set_request_id(1);
+    subscribe.mutable_subscribe_request();
+    stalled.SendMessage(subscribe.SerializeAsString());
+    for (int i = 0; i < 500 && manager->metrics().Read().counters[hello_ipc::Metrics::kSubscribeRequests] < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 20000; ++i) {
+        manager->UpdateLedState("996", i % 2 == 0 ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+    }
+
+    TestableQueryLed watcher;
+    ASSERT_TRUE(connect(watcher));
+    std::ostringstream out;
+    std::atomic<bool> done(false);
+    bool watched = false;
+    std::thread watch_thread([&]() {
+        watched = watcher.Watch({"997"}, out, 2);
+        done = true;
+    });
+    bool on = false;
+    for (int i = 0; i < 500 && !done; ++i) {
+        on = !on;
+        manager->UpdateLedState("997", on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    watch_thread.join();
+    EXPECT_TRUE(watched);
+
+    // Neither the server nor the notifier waits for the stalled subscriber on the way out
+    manager->StopServer();
+    server_thread.join();
+    manager.reset();
+    std::filesystem::remove_all("/tmp/sys/class/led_996");
+    std::filesystem::remove_all("/tmp/sys/class/led_997");
+}
+
+TEST(LedManagerSubscribeTest, AcknowledgesTheSubscriptionBeforeAnyNotification) {
+    const std::string socket_path = "/tmp/hello_ipc_led_manager_test.sock";
+    TestableLedManager manager;
+    std::thread server_thread([&manager, &socket_path]() { manager.Run(socket_path); });
+
+    TestableQueryLed client;
+    bool connected = false;
+    for (int attempt = 0; attempt < 100 && !connected; ++attempt) {
+        connected = client.ConnectToServer(socket_path);
+        if (!connected) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_TRUE(connected);
+
+    std::atomic<bool> stop_updates(false);
+    std::thread updater([&]() {
+        for (bool on = false; !stop_updates; on = !on) {
+            manager.UpdateLedState("996", on ? hello_ipc::LedState::ON : hello_ipc::LedState::OFF);
+        }
+    });
+
+    // Updates around the subscription make the server hold its responses back to batch them
+    std::vector<std::string> messages;
+    for (int i = 0; i < 2000; ++i) {
+        hello_ipc::Request update;
+        update.set_request_id(100 + i);
+        update.mutable_update_request()->set_led_id(995);
+        update.mutable_update_request()->set_state(hello_ipc::LedState::ON);
+        messages.push_back(update.SerializeAsString());
+        if (i == 7) {
+            hello_ipc::Request subscribe;
+            subscribe.set_request_id(1);
+            subscribe.mutable_subscribe_request()->add_led_ids(996);
+            messages.push_back(subscribe.SerializeAsString());
+        }
+    }
+    client.SendMessages(messages);
+
+    // Notifications echo the subscription's request id, the first such frame must be the ack
+    std::optional<hello_ipc::Response> first;
+    for (int i = 0; i < 3000 && !first; ++i) {
+        auto frame = client.ReceiveMessage();
+        ASSERT_TRUE(frame.has_value());
+        hello_ipc::Response response;
+        ASSERT_TRUE(response.ParseFromString(*frame));
+        if (response.request_id() == 1) {
+            first = response;
+        }
+    }
+    ASSERT_TRUE(first.has_value());
+    EXPECT_TRUE(first->has_subscribe_response());
+
+    stop_updates = true;
+    updater.join();
+    manager.StopServer();
+    server_thread.join();
+    std::filesystem::remove_all("/tmp/sys/class/led_995");
+    std::filesystem::remove_all("/tmp/sys/class/led_996");
+}
+
+TEST(LedManagerSubscribeTest, RejectsInvalidFilters) {
+    TestableLedManager manager;
+    hello_ipc::SubscribeRequest req;
+    req.mutable_range()->set_first(10);
+    req.mutable_range()->set_last(5);
+
+    hello_ipc::SubscribeResponse res;
+    manager.HandleSubscribeRequest(-1, 1, req, &res);
+    EXPECT_FALSE(res.error_message().empty());
+
+    req.clear_range();
+    req.add_led_nums("abc");
+    res.Clear();
+    manager.HandleSubscribeRequest(-1, 1, req, &res);
+    EXPECT_FALSE(res.error_message().empty());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,134 @@
+#include "LedStateStore.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+class LedStateStoreTest : public ::testing::Test {
+protected:
+    const std::string path = "/tmp/hello_ipc_state_store_test.leds";
+    std::map<uint32_t, hello_ipc::LedState> restored;
+    std::map<uint32_t, bool> journaled;
+
+    void SetUp() override { RemoveFiles(); }
+    void TearDown() override { RemoveFiles(); }
+
+    void RemoveFiles() {
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".journal");
+        std::filesystem::remove(path + ".tmp");
+    }
+
+    // Opens a fresh store on the files and collects what it replays, latest state per LED.
+    bool Reopen(hello_ipc::LedStateStore &store) {
+        restored.clear();
+        journaled.clear();
+        std::string error;
+        return store.Open([this](uint32_t led_id, hello_ipc::LedState led_state, bool from_journal) {
+            restored[led_id] = led_state;
+            journaled[led_id] = from_journal;
+        }, &error);
+    }
+};
+
+TEST_F(LedStateStoreTest, OpenWithoutFilesRestoresNothing) {
+    hello_ipc::LedStateStore store(path);
+    EXPECT_TRUE(Reopen(store));
+    EXPECT_TRUE(restored.empty());
+    EXPECT_EQ(store.journal_entries(), 0u);
+}
+
+TEST_F(LedStateStoreTest, RestoresSnapshotAndJournal) {
+    {
+        hello_ipc::LedStateStore store(path);
+        ASSERT_TRUE(Reopen(store));
+        ASSERT_TRUE(store.Checkpoint({{1, hello_ipc::LedState::ON}, {2, hello_ipc::LedState::OFF}}));
+        ASSERT_TRUE(store.Append({{2, hello_ipc::LedState::ON}, {3, hello_ipc::LedState::ON}}));
+        EXPECT_EQ(store.journal_entries(), 2u);
+    }
+
+    hello_ipc::LedStateStore store(path);
+    ASSERT_TRUE(Reopen(store));
+    EXPECT_EQ(restored.size(), 3u);
+    EXPECT_EQ(restored[1], hello_ipc::LedState::ON);
+    EXPECT_EQ(restored[2], hello_ipc::LedState::ON); // The journal overrides the snapshot
+    EXPECT_EQ(restored[3], hello_ipc::LedState::ON);
+    EXPECT_FALSE(journaled[1]);
+    EXPECT_TRUE(journaled[2]);
+    EXPECT_TRUE(journaled[3]);
+    EXPECT_EQ(store.journal_entries(), 2u);
+}
+
+TEST_F(LedStateStoreTest, CheckpointEmptiesTheJournal) {
+    hello_ipc::LedStateStore store(path);
+    ASSERT_TRUE(Reopen(store));
+    ASSERT_TRUE(store.Append({{5, hello_ipc::LedState::ON}}));
+    ASSERT_TRUE(store.Checkpoint({{5, hello_ipc::LedState::ON}}));
+    EXPECT_EQ(store.journal_entries(), 0u);
+    EXPECT_EQ(std::filesystem::file_size(path + ".journal"), 24u); // Header only
+}
+
+TEST_F(LedStateStoreTest, IgnoresJournalOfAnOlderSnapshot) {
+    {
+        hello_ipc::LedStateStore store(path);
+        ASSERT_TRUE(Reopen(store));
+        ASSERT_TRUE(store.Append({{7, hello_ipc::LedState::ON}}));
+    }
+    std::filesystem::copy_file(path + ".journal", "/tmp/hello_ipc_state_store_test.old",
+                               std::filesystem::copy_options::overwrite_existing);
+    {
+        hello_ipc::LedStateStore store(path);
+        ASSERT_TRUE(Reopen(store));
+        ASSERT_TRUE(store.Checkpoint({{7, hello_ipc::LedState::OFF}}));
+    }
+    // As if the process died after renaming the snapshot but before resetting the journal
+    std::filesystem::rename("/tmp/hello_ipc_state_store_test.old", path + ".journal");
+
+    hello_ipc::LedStateStore store(path);
+    ASSERT_TRUE(Reopen(store));
+    EXPECT_EQ(restored.size(), 1u);
+    EXPECT_EQ(restored[7], hello_ipc::LedState::OFF);
+    EXPECT_EQ(store.journal_entries(), 0u);
+}
+
+TEST_F(LedStateStoreTest, DropsTornJournalTail) {
+    {
+        hello_ipc::LedStateStore store(path);
+        ASSERT_TRUE(Reopen(store));
+        ASSERT_TRUE(store.Append({{9, hello_ipc::LedState::ON}}));
+    }
+    {
+        std::ofstream journal(path + ".journal", std::ios::binary | std::ios::app);
+        journal.write("\x0a\x00\x00", 3); // Part of an entry
+    }
+
+    hello_ipc::LedStateStore store(path);
+    ASSERT_TRUE(Reopen(store));
+    EXPECT_EQ(restored.size(), 1u);
+    ASSERT_TRUE(store.Append({{10, hello_ipc::LedState::ON}}));
+
+    hello_ipc::LedStateStore reopened(path);
+    ASSERT_TRUE(Reopen(reopened));
+    EXPECT_EQ(restored.size(), 2u);
+    EXPECT_EQ(restored[10], hello_ipc::LedState::ON);
+}
+
+TEST_F(LedStateStoreTest, RejectsCorruptSnapshot) {
+    {
+        std::ofstream snapshot(path, std::ios::binary);
+        snapshot << "not a snapshot of any kind";
+    }
+
+    hello_ipc::LedStateStore store(path);
+    std::string error;
+    EXPECT_FALSE(store.Open([](uint32_t, hello_ipc::LedState, bool) {}, &error));
+    EXPECT_FALSE(error.empty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+#include "LedManager.hpp"
+#include "LoadGenerator.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Test subclass to stop the server from the test thread
+class TestableLedManager : public hello_ipc::LedManager {
+public:
+    using hello_ipc::LedManager::StopServer;
+};
+
+static bool Parse(std::vector<std::string> args, hello_ipc::LoadGenerator::Options *options) {
+    std::vector<char *> argv;
+    for (auto &arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    return hello_ipc::LoadGenerator::ParseArguments(static_cast<int>(argv.size()), argv.data(), options);
+}
+
+// --- Unit Tests for the option parsing ---
+
+TEST(LoadGeneratorTest, ParseArgumentsReadsEveryOption) {
+    hello_ipc::LoadGenerator::Options options;
+    ASSERT_TRUE(Parse({"hello_ipc", "--load-gen", "--connections", "16", "--update-ratio", "0.9",
+                       "--keys", "64", "--zipf", "1.2", "--compact", "--rate", "1000", "--duration", "0.5"},
+                      &options));
+    EXPECT_EQ(options.connections, 16u);
+    EXPECT_DOUBLE_EQ(options.update_ratio, 0.9);
+    EXPECT_EQ(options.keys, 64u);
+    EXPECT_DOUBLE_EQ(options.zipf_skew, 1.2);
+    EXPECT_DOUBLE_EQ(options.rate, 1000);
+    EXPECT_DOUBLE_EQ(options.duration_s, 0.5);
+    EXPECT_TRUE(options.compact);
+}
+
+TEST(LoadGeneratorTest, ParseArgumentsRejectsInvalidOptions) {
+    hello_ipc::LoadGenerator::Options options;
+    EXPECT_FALSE(Parse({"hello_ipc", "--load-gen", "--unknown", "1"}, &options));
+    EXPECT_FALSE(Parse({"hello_ipc", "--load-gen", "--connections"}, &options));
+    EXPECT_FALSE(Parse({"hello_ipc", "--load-gen", "--connections", "0"}, &options));
+    EXPECT_FALSE(Parse({"hello_ipc", "--load-gen", "--update-ratio", "1.5"}, &options));
+    EXPECT_FALSE(Parse({"hello_ipc", "--load-gen", "--rate", "fast"}, &options));
+}
+
+// --- Integration Tests against a live LedManager ---
+
+class LoadGeneratorServerTest : public ::testing::Test {
+protected:
+    const std::string socket_path = "/tmp/hello_ipc_load_gen_test.sock";
+    TestableLedManager server;
+    std::thread server_thread;
+
+    void SetUp() override {
+        server_thread = std::thread([this]() { server.Run(socket_path); });
+    }
+
+    void TearDown() override {
+        server.StopServer();
+        server_thread.join();
+    }
+
+    // Runs the generator, retrying while the server thread is still starting up.
+    hello_ipc::LoadGenerator::Report RunLoad(const hello_ipc::LoadGenerator::Options &options) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            hello_ipc::LoadGenerator generator(socket_path, options);
+            if (generator.Run() && generator.report().errors == 0) {
+                return generator.report();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return hello_ipc::LoadGenerator::Report();
+    }
+};
+
+TEST_F(LoadGeneratorServerTest, ClosedLoopCompletesRequests) {
+    hello_ipc::LoadGenerator::Options options;
+    options.connections = 2;
+    options.keys = 16;
+    options.zipf_skew = 0.99;
+    options.duration_s = 0.2;
+
+    auto report = RunLoad(options);
+    EXPECT_GT(report.requests, 0u);
+    EXPECT_EQ(report.errors, 0u);
+    EXPECT_EQ(report.latency_ns.count(), report.requests);
+    EXPECT_GT(report.latency_ns.Percentile(50), 0u);
+}
+
+TEST_F(LoadGeneratorServerTest, OpenLoopSendsAtTheConfiguredRate) {
+    hello_ipc::LoadGenerator::Options options;
+    options.connections = 2;
+    options.keys = 16;
+    options.rate = 200;
+    options.duration_s = 0.25;
+
+    auto report = RunLoad(options);
+    EXPECT_EQ(report.errors, 0u);
+    EXPECT_EQ(report.requests, 50u);
+}
+
+TEST_F(LoadGeneratorServerTest, CompactFormatCompletesRequests) {
+    hello_ipc::LoadGenerator::Options options;
+    options.connections = 2;
+    options.keys = 16;
+    options.duration_s = 0.2;
+    options.compact = true;
+
+    auto report = RunLoad(options);
+    EXPECT_GT(report.requests, 0u);
+    EXPECT_EQ(report.errors, 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+#include "LogRecord.hpp"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for structured log records ---
+
+static std::string Format(const char *record, std::size_t size) {
+    std::string text;
+    EXPECT_TRUE(hello_ipc::FormatLogRecord(record, size, text));
+    return text;
+}
+
+TEST(LogRecordTest, FormatsStringAndIntegerArguments) {
+    hello_ipc::LogArgs args;
+    args.Add(3);
+    args.Add(std::string("4"));
+
+    char record[hello_ipc::kLogRecordMaxSize];
+    std::size_t size = hello_ipc::EncodeLogRecord(hello_ipc::LogId::kBatchUpdated, 0, args, record);
+    EXPECT_EQ(Format(record, size), "Batch update: 3 of 4 LEDs updated");
+}
+
+TEST(LogRecordTest, KeepsTimestampAndSignedValues) {
+    hello_ipc::LogArgs args;
+    args.Add(-42);
+
+    char record[hello_ipc::kLogRecordMaxSize];
+    std::size_t size = hello_ipc::EncodeLogRecord(hello_ipc::LogId::kMessage, 123456789ULL, args, record);
+
+    std::string text;
+    uint64_t timestamp_ns = 0;
+    ASSERT_TRUE(hello_ipc::FormatLogRecord(record, size, text, &timestamp_ns));
+    EXPECT_EQ(text, "-42");
+    EXPECT_EQ(timestamp_ns, 123456789ULL);
+}
+
+TEST(LogRecordTest, MissingArgumentsArePrintedAsPlaceholders) {
+    hello_ipc::LogArgs args;
+    args.Add("7");
+
+    char record[hello_ipc::kLogRecordMaxSize];
+    std::size_t size = hello_ipc::EncodeLogRecord(hello_ipc::LogId::kUpdateReceived, 0, args, record);
+    EXPECT_EQ(Format(record, size), "Received update for LED: 7 to state: ?");
+}
+
+TEST(LogRecordTest, TruncatesLongStringsToTheRecordSize) {
+    hello_ipc::LogArgs args;
+    args.Add(std::string(1000, 'x'));
+    EXPECT_LE(args.size(), hello_ipc::kLogRecordMaxSize - hello_ipc::kLogRecordHeaderSize);
+
+    char record[hello_ipc::kLogRecordMaxSize];
+    std::size_t size = hello_ipc::EncodeLogRecord(hello_ipc::LogId::kMessage, 0, args, record);
+    std::string text = Format(record, size);
+    EXPECT_FALSE(text.empty());
+    EXPECT_EQ(text.find_first_not_of('x'), std::string::npos);
+}
+
+TEST(LogRecordTest, RejectsUnknownIdsAndTruncatedRecords) {
+    hello_ipc::LogArgs args;
+    args.Add("7");
+    char record[hello_ipc::kLogRecordMaxSize];
+    std::size_t size = hello_ipc::EncodeLogRecord(hello_ipc::LogId::kQueryReceived, 0, args, record);
+
+    std::string text;
+    EXPECT_FALSE(hello_ipc::FormatLogRecord(record, size - 1, text));
+    EXPECT_FALSE(hello_ipc::FormatLogRecord(record, 3, text));
+
+    uint16_t unknown = 0xffff;
+    memcpy(record, &unknown, sizeof(unknown));
+    EXPECT_FALSE(hello_ipc::FormatLogRecord(record, size, text));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
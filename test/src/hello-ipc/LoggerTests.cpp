@@ -1,8 +1,11 @@
 #include "hello-ipc/Logger.hpp"
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -98,4 +101,108 @@ TEST_F(LoggerTest, ConstructorThrowsOnInvalidPath) {
 
     // Verify that our test helper returns an empty string for a non-existent file.
     EXPECT_EQ(readFileContent("/tmp/" + invalidServiceName + ".log"), "");
-}
\ No newline at end of file
+}
+
+TEST_F(LoggerTest, AsyncModeWritesMessagesInOrderOnFlush) {
+    hello_ipc::Logger logger(service_name, hello_ipc::Logger::Mode::kAsync);
+    std::string expectedContent;
+    for (int i = 0; i < 100; ++i) {
+        const std::string message = "Message " + std::to_string(i);
+        logger.Log(message);
+        expectedContent += "[" + service_name + "]: " + message + "\n";
+    }
+
+    logger.Flush();
+    EXPECT_EQ(readFileContent(logFilePath), expectedContent);
+    EXPECT_EQ(logger.dropped(), 0u);
+}
+
+TEST_F(LoggerTest, AsyncModeKeepsLinesIntactAcrossThreads) {
+    const int kThreads = 4;
+    const int kMessagesPerThread = 500;
+    uint64_t dropped = 0;
+    {
+        hello_ipc::Logger logger(service_name, hello_ipc::Logger::Mode::kAsync);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < kMessagesPerThread; ++i) {
+                    logger.Log("thread " + std::to_string(t) + " message " + std::to_string(i));
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        dropped = logger.dropped();
+    } // The destructor writes what is still queued
+
+    std::ifstream file(logFilePath);
+    std::string line;
+    int lines = 0;
+    while (std::getline(file, line)) {
+        if (line.find("Dropped") != std::string::npos) {
+            continue;
+        }
+        EXPECT_EQ(line.rfind("[" + service_name + "]: thread ", 0), 0u) << line;
+        ++lines;
+    }
+    EXPECT_EQ(static_cast<uint64_t>(lines) + dropped, static_cast<uint64_t>(kThreads * kMessagesPerThread));
+}
+
+TEST_F(LoggerTest, AsyncModeTruncatesLongMessages) {
+    const std::string message(1000, 'x');
+    {
+        hello_ipc::Logger logger(service_name, hello_ipc::Logger::Mode::kAsync);
+        logger.Log(message);
+    }
+
+    const std::string actualContent = readFileContent(logFilePath);
+    ASSERT_FALSE(actualContent.empty());
+    EXPECT_LT(actualContent.size(), message.size());
+    EXPECT_EQ(actualContent.back(), '\n');
+}
+
+TEST_F(LoggerTest, AsyncModeFormatsStructuredMessages) {
+    {
+        hello_ipc::Logger logger(service_name, hello_ipc::Logger::Mode::kAsync);
+        logger.Log(hello_ipc::LogId::kUpdateReceived, std::string("12"), "on");
+    }
+
+    EXPECT_EQ(readFileContent(logFilePath), "[" + service_name + "]: Received update for LED: 12 to state: on\n");
+}
+
+TEST_F(LoggerTest, BinaryFormatWritesHeaderAndRecords) {
+    const std::string binaryLogPath = "/tmp/" + service_name + ".binlog";
+    std::filesystem::remove(binaryLogPath);
+    {
+        hello_ipc::Logger logger(service_name, hello_ipc::Logger::Mode::kSync, hello_ipc::Logger::Format::kBinary);
+        logger.Log(hello_ipc::LogId::kQueryReceived, std::string("5"));
+        logger.Log("plain");
+    }
+
+    const std::string content = readFileContent(binaryLogPath);
+    std::filesystem::remove(binaryLogPath);
+    EXPECT_FALSE(std::filesystem::exists(logFilePath));
+
+    const std::size_t magic_size = sizeof(hello_ipc::kBinaryLogMagic);
+    ASSERT_GT(content.size(), magic_size + 2 + service_name.size());
+    EXPECT_EQ(content.compare(0, magic_size, std::string(hello_ipc::kBinaryLogMagic, magic_size)), 0);
+    EXPECT_EQ(content.compare(magic_size + 2, service_name.size(), service_name), 0);
+
+    std::size_t pos = magic_size + 2 + service_name.size();
+    std::vector<std::string> messages;
+    while (pos + 2 <= content.size()) {
+        uint16_t size;
+        memcpy(&size, content.data() + pos, sizeof(size));
+        pos += sizeof(size);
+        ASSERT_LE(pos + size, content.size());
+        std::string text;
+        ASSERT_TRUE(hello_ipc::FormatLogRecord(content.data() + pos, size, text));
+        messages.push_back(text);
+        pos += size;
+    }
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0], "Received query for LED: 5");
+    EXPECT_EQ(messages[1], "plain");
+}
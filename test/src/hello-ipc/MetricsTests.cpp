@@ -0,0 +1,79 @@
+#include "Metrics.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for the per-thread metrics ---
+
+TEST(MetricsTest, ReadMergesCountersOfEveryThread) {
+    hello_ipc::Metrics metrics;
+    const int kThreads = 4;
+    const int kIncrements = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&metrics]() {
+            for (int i = 0; i < kIncrements; ++i) {
+                metrics.Add(hello_ipc::Metrics::kUpdateRequests);
+                metrics.Add(hello_ipc::Metrics::kBytesIn, 10);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto snapshot = metrics.Read();
+    EXPECT_EQ(snapshot.counters[hello_ipc::Metrics::kUpdateRequests], static_cast<uint64_t>(kThreads * kIncrements));
+    EXPECT_EQ(snapshot.counters[hello_ipc::Metrics::kBytesIn], static_cast<uint64_t>(kThreads * kIncrements * 10));
+    EXPECT_EQ(snapshot.counters[hello_ipc::Metrics::kQueryRequests], 0u);
+}
+
+TEST(MetricsTest, DecrementsOnOtherThreadsCancelOut) {
+    hello_ipc::Metrics metrics;
+    metrics.Add(hello_ipc::Metrics::kActiveConnections);
+    metrics.Add(hello_ipc::Metrics::kActiveConnections);
+    std::thread([&metrics]() { metrics.Add(hello_ipc::Metrics::kActiveConnections, -1); }).join();
+
+    EXPECT_EQ(metrics.Read().counters[hello_ipc::Metrics::kActiveConnections], 1u);
+}
+
+TEST(MetricsTest, RecordsLatencyPerStage) {
+    hello_ipc::Metrics metrics;
+    metrics.RecordLatency(hello_ipc::Metrics::kParse, 100);
+    std::thread([&metrics]() { metrics.RecordLatency(hello_ipc::Metrics::kParse, 300); }).join();
+    metrics.RecordLatency(hello_ipc::Metrics::kSend, 50);
+
+    auto snapshot = metrics.Read();
+    EXPECT_EQ(snapshot.stages[hello_ipc::Metrics::kParse].count(), 2u);
+    EXPECT_EQ(snapshot.stages[hello_ipc::Metrics::kParse].max(), 300u);
+    EXPECT_EQ(snapshot.stages[hello_ipc::Metrics::kSend].count(), 1u);
+    EXPECT_EQ(snapshot.stages[hello_ipc::Metrics::kHandle].count(), 0u);
+}
+
+TEST(MetricsTest, InstancesDoNotShareShards) {
+    hello_ipc::Metrics first;
+    first.Add(hello_ipc::Metrics::kStatsRequests);
+    {
+        hello_ipc::Metrics second;
+        second.Add(hello_ipc::Metrics::kStatsRequests, 5);
+        EXPECT_EQ(second.Read().counters[hello_ipc::Metrics::kStatsRequests], 5u);
+    }
+    hello_ipc::Metrics third;
+    EXPECT_EQ(third.Read().counters[hello_ipc::Metrics::kStatsRequests], 0u);
+    first.Add(hello_ipc::Metrics::kStatsRequests);
+    EXPECT_EQ(first.Read().counters[hello_ipc::Metrics::kStatsRequests], 2u);
+}
+
+TEST(MetricsTest, StageNamesAreStable) {
+    EXPECT_STREQ(hello_ipc::Metrics::StageName(hello_ipc::Metrics::kRecv), "recv");
+    EXPECT_STREQ(hello_ipc::Metrics::StageName(hello_ipc::Metrics::kSerialize), "serialize");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
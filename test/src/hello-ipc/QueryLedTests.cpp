@@ -45,7 +45,8 @@ TEST(QueryLedTest, QueryStateSendsCorrectProtobufMessage) {
     hello_ipc::Request sent_req;
     ASSERT_TRUE(sent_req.ParseFromString(client.sentMessages[0]));
     ASSERT_TRUE(sent_req.has_query_request());
-    EXPECT_EQ(sent_req.query_request().led_num(), "1");
+    EXPECT_EQ(sent_req.query_request().led_id(), 1u);
+    EXPECT_TRUE(sent_req.query_request().led_num().empty());
 }
 
 TEST(QueryLedTest, QueryStatePrintsCorrectResponse) {
@@ -69,6 +70,25 @@ TEST(QueryLedTest, QueryStatePrintsCorrectResponse) {
     EXPECT_NE(output.find("Response: Led1=on"), std::string::npos);
 }
 
+TEST(QueryLedTest, QueryStatePrintsNumericLedId) {
+    TestableQueryLed client;
+
+    hello_ipc::Response mock_res;
+    auto* state_res = mock_res.mutable_state_response();
+    state_res->set_led_id(42);
+    state_res->set_state(hello_ipc::LedState::OFF);
+
+    std::string response_str;
+    mock_res.SerializeToString(&response_str);
+    client.responses.push_back(response_str);
+
+    testing::internal::CaptureStdout();
+    client.queryState("42");
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(output.find("Response: Led42=off"), std::string::npos);
+}
+
 TEST(QueryLedTest, QueryStateHandlesServerErrorResponse) {
     TestableQueryLed client;
 
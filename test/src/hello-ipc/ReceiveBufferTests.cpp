@@ -0,0 +1,76 @@
+#include "ReceiveBuffer.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for ReceiveBuffer ---
+
+TEST(ReceiveBufferTest, CommittedBytesBecomeReadable) {
+    hello_ipc::ReceiveBuffer buffer(64);
+    char *space = buffer.Reserve(5);
+    ASSERT_GE(buffer.writable(), 5u);
+    memcpy(space, "hello", 5);
+    buffer.Commit(5);
+
+    EXPECT_EQ(buffer.readable(), "hello");
+    buffer.Consume(2);
+    EXPECT_EQ(buffer.readable(), "llo");
+    EXPECT_EQ(buffer.size(), 3u);
+}
+
+TEST(ReceiveBufferTest, CompactsInPlaceWhenUnpinned) {
+    hello_ipc::ReceiveBuffer buffer(16);
+    buffer.Append("0123456789abcdef", 16);
+    buffer.Consume(12);
+    const char *before = buffer.readable().data() - 12;
+
+    buffer.Append("xyz", 3);
+    EXPECT_EQ(buffer.readable(), "cdefxyz");
+    EXPECT_EQ(buffer.readable().data(), before); // Same block, tail moved to the front
+}
+
+TEST(ReceiveBufferTest, PinnedBytesAreNeverOverwritten) {
+    hello_ipc::ReceiveBuffer buffer(16);
+    buffer.Append("0123456789abcdef", 16);
+    std::string_view frame = buffer.readable().substr(0, 10);
+    auto pin = buffer.Pin();
+    buffer.Consume(10);
+
+    buffer.Append("ZZZZZZZZZZ", 10);
+    EXPECT_EQ(frame, "0123456789");
+    EXPECT_EQ(buffer.readable(), "abcdefZZZZZZZZZZ");
+}
+
+TEST(ReceiveBufferTest, ReusesTheSpareBlockOnceReleased) {
+    hello_ipc::ReceiveBuffer buffer(16);
+    buffer.Append("0123456789abcdef", 16);
+    const char *first = buffer.readable().data();
+    auto pin = buffer.Pin();
+    buffer.Consume(16);
+
+    buffer.Append("a", 1); // Moves to a new block, the first one is still pinned
+    const char *second = buffer.readable().data();
+    EXPECT_NE(second, first);
+
+    pin.reset();
+    buffer.Append("bcdefghijklmnop", 15);
+    auto second_pin = buffer.Pin();
+    buffer.Consume(16);
+    buffer.Append("q", 1); // The released first block is taken back as the spare
+    EXPECT_EQ(buffer.readable().data(), first);
+}
+
+TEST(ReceiveBufferTest, GrowsForLargeReservations) {
+    hello_ipc::ReceiveBuffer buffer(8);
+    buffer.Append("abc", 3);
+    buffer.Reserve(100);
+    EXPECT_GE(buffer.writable(), 100u);
+    EXPECT_EQ(buffer.readable(), "abc");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,11 @@
 #include "Service.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 // Test subclass to expose protected methods for testing
@@ -11,8 +17,37 @@ public:
     // Expose protected methods for testing
     using hello_ipc::Service::ConnectToServer;
     using hello_ipc::Service::SetSocketFd;
+    using hello_ipc::Service::RunServer;
+    using hello_ipc::Service::StopServer;
+    using hello_ipc::Service::SendResponse;
+    using hello_ipc::Service::SetWireFormat;
+    using hello_ipc::Service::ClientUsesCompactFormat;
+    using hello_ipc::Service::metrics;
+    using hello_ipc::Service::ClientQueueDepths;
+};
+
+// Answers messages over the in-flight limit instead of dropping them.
+class OverloadReportingService : public TestableService {
+public:
+    using TestableService::TestableService;
+
+protected:
+    std::optional<std::string> OverloadedResponse(std::string_view message, WireFormat) const override {
+        return "overloaded:" + std::string(message);
+    }
 };
 
+// Connects a client, retrying while the server thread is still starting up.
+static bool ConnectWithRetry(TestableService &client, const std::string &socket_path) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (client.ConnectToServer(socket_path)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
 // --- Unit Tests for Service Class ---
 // These tests do not require a live server and focus on error handling paths.
 
@@ -41,6 +76,432 @@ TEST(ServiceTest, ReceiveMessageFailsIfSocketInvalid) {
     EXPECT_FALSE(result.has_value());
 }
 
+// --- Tests against a live server loop ---
+
+// Runs an echo server on the given backend and checks framing and per-client ordering.
+static void ExpectServerEchoes(hello_ipc::Service::ServerBackend backend) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    TestableService server("svc_server");
+    server.SetServerBackend(backend);
+    std::thread server_thread([&server, &socket_path]() {
+        server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService client1("svc_client");
+    TestableService client2("svc_client");
+    EXPECT_TRUE(ConnectWithRetry(client1, socket_path));
+    EXPECT_TRUE(ConnectWithRetry(client2, socket_path));
+
+    // Several messages in a row must come back complete and in order
+    for (int i = 0; i < 3; ++i) {
+        client1.SendMessage("a" + std::to_string(i));
+    }
+    client2.SendMessage("b");
+
+    EXPECT_EQ(client2.ReceiveMessage(), std::optional<std::string>("echo:b"));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(client1.ReceiveMessage(), std::optional<std::string>("echo:a" + std::to_string(i)));
+    }
+
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, RunServerEchoesMessagesToMultipleClients) {
+    ExpectServerEchoes(hello_ipc::Service::ServerBackend::kEpoll);
+}
+
+TEST(ServiceTest, RunServerEchoesMessagesWithIoUringBackend) {
+    // Falls back to epoll where io_uring is unavailable, the behavior must be identical
+    ExpectServerEchoes(hello_ipc::Service::ServerBackend::kIoUring);
+}
+
+TEST(ServiceTest, ThreadsOutsideTheWorkersCanSendWhileTheServerStops) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    for (auto backend : {hello_ipc::Service::ServerBackend::kEpoll, hello_ipc::Service::ServerBackend::kIoUring}) {
+        TestableService server("svc_server");
+        server.SetServerBackend(backend);
+        std::atomic<int> subscriber{-1};
+        std::thread server_thread([&server, &socket_path, &subscriber]() {
+            server.RunServer(socket_path, [&server, &subscriber](int client_socket, std::string_view msg) {
+                subscriber = client_socket;
+                server.SendResponse(client_socket, "echo:" + std::string(msg));
+            });
+        });
+
+        TestableService client("svc_client");
+        ASSERT_TRUE(ConnectWithRetry(client, socket_path));
+        client.SendMessage("a");
+        EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:a"));
+
+        // Like a notifier thread, keeps sending while the loop tears its backend down
+        std::atomic<bool> done{false};
+        std::thread sender([&server, &subscriber, &done]() {
+            while (!done) {
+                server.SendResponse(subscriber, "update");
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        server.StopServer();
+        server_thread.join();
+        done = true;
+        sender.join();
+    }
+}
+
+TEST(ServiceTest, SharedMemoryTransportEchoesMessages) {
+    // Clients pick the transport from the environment when they connect
+    setenv("HELLO_IPC_TRANSPORT", "shm", 1);
+    ExpectServerEchoes(hello_ipc::Service::ServerBackend::kEpoll);
+    unsetenv("HELLO_IPC_TRANSPORT");
+}
+
+TEST(ServiceTest, StopBeforeRunServerMakesItReturnRightAway) {
+    TestableService server("svc_server");
+    server.StopServer(); // E.g. a signal that arrives while the server is still starting
+    server.RunServer("/tmp/hello_ipc_service_test.sock", [](int, std::string_view) {});
+
+    // The latch is cleared once the loop returned, so the server can run again
+    std::thread server_thread([&server]() {
+        server.RunServer("/tmp/hello_ipc_service_test.sock", [](int, std::string_view) {});
+    });
+    TestableService client("svc_client");
+    EXPECT_TRUE(ConnectWithRetry(client, "/tmp/hello_ipc_service_test.sock"));
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, PipelinedMessagesAreAnsweredInOrder) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    TestableService server("svc_server");
+    std::thread server_thread([&server, &socket_path]() {
+        server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService client("svc_client");
+    EXPECT_TRUE(ConnectWithRetry(client, socket_path));
+
+    // Enough queued requests that the server corks several responses into one write
+    std::vector<std::string> messages;
+    for (int i = 0; i < 2000; ++i) {
+        messages.push_back("m" + std::to_string(i));
+    }
+    client.SendMessages(messages);
+    for (int i = 0; i < 2000; ++i) {
+        ASSERT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:m" + std::to_string(i)));
+    }
+
+    server.StopServer();
+    server_thread.join();
+}
+
+// Answers every message with a response close to the maximum frame size.
+static void RunPaddingServer(TestableService &server, const std::string &socket_path) {
+    server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+        server.SendResponse(client_socket, std::string(msg) + std::string(4000, '.'));
+    });
+}
+
+// Sends more responses than the transport buffers, and reads them only afterwards.
+static void ExpectBufferedResponsesArrive() {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    TestableService server("svc_server");
+    std::thread server_thread([&server, &socket_path]() { RunPaddingServer(server, socket_path); });
+
+    TestableService client("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(client, socket_path));
+    std::vector<std::string> messages;
+    for (int i = 0; i < 100; ++i) {
+        messages.push_back("m" + std::to_string(i));
+    }
+    client.SendMessages(messages); // About 400 KB of responses, more than the socket or ring buffers
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (int i = 0; i < 100; ++i) {
+        auto response = client.ReceiveMessage();
+        ASSERT_TRUE(response.has_value());
+        EXPECT_EQ(response->substr(0, response->find('.')), "m" + std::to_string(i));
+    }
+
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, ResponsesTheSocketCannotTakeAreSentOnceTheClientReads) {
+    ExpectBufferedResponsesArrive();
+}
+
+TEST(ServiceTest, ResponsesAFullRingCannotTakeAreSentOnceTheClientReads) {
+    setenv("HELLO_IPC_TRANSPORT", "shm", 1);
+    ExpectBufferedResponsesArrive();
+    unsetenv("HELLO_IPC_TRANSPORT");
+}
+
+TEST(ServiceTest, ClientThatDoesNotReadDoesNotStallOthers) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    TestableService server("svc_server");
+    std::thread server_thread([&server, &socket_path]() { RunPaddingServer(server, socket_path); });
+
+    TestableService flooder("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(flooder, socket_path));
+    flooder.SendMessages(std::vector<std::string>(1000, "f")); // About 4 MB of responses, never read
+
+    // Served by the same worker, which must not wait for the flooder's socket
+    TestableService client("svc_client");
+    ASSERT_TRUE(client.ConnectToServer(socket_path));
+    client.SendMessage("c");
+    auto response = client.ReceiveMessage();
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(response->substr(0, 2), "c.");
+
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, CompactFormatIsNegotiatedPerClient) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    for (auto backend : {hello_ipc::Service::ServerBackend::kEpoll, hello_ipc::Service::ServerBackend::kIoUring}) {
+        TestableService server("svc_server");
+        server.SetServerBackend(backend);
+        std::thread server_thread([&server, &socket_path]() {
+            server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+                std::string format = server.ClientUsesCompactFormat() ? "compact:" : "protobuf:";
+                server.SendResponse(client_socket, format + std::string(msg));
+            });
+        });
+
+        TestableService compact_client("svc_client");
+        TestableService default_client("svc_client");
+        compact_client.SetWireFormat(hello_ipc::Service::WireFormat::kCompact);
+        EXPECT_TRUE(ConnectWithRetry(compact_client, socket_path));
+        EXPECT_TRUE(ConnectWithRetry(default_client, socket_path));
+
+        compact_client.SendMessage("a");
+        default_client.SendMessage("b");
+        EXPECT_EQ(compact_client.ReceiveMessage(), std::optional<std::string>("compact:a"));
+        EXPECT_EQ(default_client.ReceiveMessage(), std::optional<std::string>("protobuf:b"));
+
+        server.StopServer();
+        server_thread.join();
+    }
+}
+
+TEST(ServiceTest, ConnectionsOverTheLimitAreClosed) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    for (auto backend : {hello_ipc::Service::ServerBackend::kEpoll, hello_ipc::Service::ServerBackend::kIoUring}) {
+        TestableService server("svc_server");
+        server.SetServerBackend(backend);
+        hello_ipc::Service::ServerLimits limits;
+        limits.max_connections = 1;
+        server.SetServerLimits(limits);
+        std::thread server_thread([&server, &socket_path]() {
+            server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+                server.SendResponse(client_socket, "echo:" + std::string(msg));
+            });
+        });
+
+        TestableService admitted("svc_client");
+        ASSERT_TRUE(ConnectWithRetry(admitted, socket_path));
+        admitted.SendMessage("a");
+        EXPECT_EQ(admitted.ReceiveMessage(), std::optional<std::string>("echo:a"));
+
+        // The kernel completes the connect, then the server closes the extra client
+        TestableService rejected("svc_client");
+        ASSERT_TRUE(rejected.ConnectToServer(socket_path));
+        rejected.SendMessage("b");
+        EXPECT_FALSE(rejected.ReceiveMessage().has_value());
+        EXPECT_EQ(server.metrics().Read().counters[hello_ipc::Metrics::kRejectedConnections], 1u);
+
+        admitted.SendMessage("c");
+        EXPECT_EQ(admitted.ReceiveMessage(), std::optional<std::string>("echo:c"));
+
+        server.StopServer();
+        server_thread.join();
+    }
+}
+
+TEST(ServiceTest, SharedMemoryClientsCountOnceTowardsTheConnectionLimit) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    setenv("HELLO_IPC_TRANSPORT", "shm", 1);
+    TestableService server("svc_server");
+    hello_ipc::Service::ServerLimits limits;
+    limits.max_connections = 2;
+    server.SetServerLimits(limits);
+    std::thread server_thread([&server, &socket_path]() {
+        server.RunServer(socket_path, [&server](int client_socket, std::string_view msg) {
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService first("svc_client");
+    TestableService second("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(first, socket_path));
+    ASSERT_TRUE(second.ConnectToServer(socket_path));
+    second.SendMessage("b");
+    EXPECT_EQ(second.ReceiveMessage(), std::optional<std::string>("echo:b"));
+    EXPECT_EQ(server.metrics().Read().counters[hello_ipc::Metrics::kRejectedConnections], 0u);
+
+    server.StopServer();
+    server_thread.join();
+    unsetenv("HELLO_IPC_TRANSPORT");
+}
+
+TEST(ServiceTest, MessagesOverTheInFlightLimitAreAnsweredAsOverloaded) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    OverloadReportingService server("svc_server");
+    hello_ipc::Service::ServerLimits limits;
+    limits.max_in_flight = 1;
+    server.SetServerLimits(limits);
+    std::atomic<bool> release{false};
+    std::thread server_thread([&]() {
+        server.RunServer(socket_path, [&](int client_socket, std::string_view msg) {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService client("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(client, socket_path));
+    client.SendMessages({"m0", "m1", "m2"});
+
+    // m0 holds the only slot until the handler is released, so m1 and m2 are turned away right away
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("overloaded:m1"));
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("overloaded:m2"));
+    EXPECT_EQ(server.metrics().Read().counters[hello_ipc::Metrics::kOverloadedRequests], 2u);
+    EXPECT_EQ(server.ClientQueueDepths()[0].second, 1); // Only m0 was queued
+    release = true;
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:m0"));
+
+    // The slot is free again
+    client.SendMessage("m3");
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:m3"));
+
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, ClientQueueDepthsReportsMessagesWaitingForAWorker) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    TestableService server("svc_server");
+    std::atomic<bool> release{false};
+    std::thread server_thread([&]() {
+        server.RunServer(socket_path, [&](int client_socket, std::string_view msg) {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService client("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(client, socket_path));
+    client.SendMessages({"m0", "m1", "m2"});
+
+    std::vector<std::pair<int, int>> depths;
+    for (int i = 0; i < 500; ++i) {
+        depths = server.ClientQueueDepths();
+        if (depths.size() == 1 && depths[0].second == 3) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(depths.size(), 1u);
+    EXPECT_EQ(depths[0].second, 3);
+
+    release = true;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:m" + std::to_string(i)));
+    }
+    EXPECT_EQ(server.ClientQueueDepths()[0].second, 0);
+
+    server.StopServer();
+    server_thread.join();
+}
+
+// Puts messages starting with 'r' in the interactive lane.
+class LaneSplittingService : public TestableService {
+public:
+    using TestableService::TestableService;
+
+protected:
+    Lane ClassifyMessage(std::string_view message, WireFormat) const override {
+        return !message.empty() && message[0] == 'r' ? Lane::kInteractive : Lane::kBulk;
+    }
+};
+
+TEST(ServiceTest, InteractiveLaneDoesNotWaitForBulkLane) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    LaneSplittingService server("svc_server");
+    std::atomic<bool> release{false};
+    std::thread server_thread([&]() {
+        server.RunServer(socket_path, [&](int client_socket, std::string_view msg) {
+            while (msg[0] == 'w' && !release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService writer("svc_client");
+    TestableService reader("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(writer, socket_path));
+    ASSERT_TRUE(ConnectWithRetry(reader, socket_path));
+    writer.SendMessages({"w0", "w1"});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Let the bulk worker get stuck
+    reader.SendMessages({"r0", "r1"});
+
+    // The reads of the other client overtake the stuck writes
+    EXPECT_EQ(reader.ReceiveMessage(), std::optional<std::string>("echo:r0"));
+    EXPECT_EQ(reader.ReceiveMessage(), std::optional<std::string>("echo:r1"));
+    release = true;
+    EXPECT_EQ(writer.ReceiveMessage(), std::optional<std::string>("echo:w0"));
+    EXPECT_EQ(writer.ReceiveMessage(), std::optional<std::string>("echo:w1"));
+
+    server.StopServer();
+    server_thread.join();
+}
+
+TEST(ServiceTest, LanesKeepTheOrderOfOneClient) {
+    const std::string socket_path = "/tmp/hello_ipc_service_test.sock";
+    LaneSplittingService server("svc_server");
+    std::atomic<bool> release{false};
+    std::atomic<bool> write_done{false};
+    std::atomic<bool> read_saw_write{false};
+    std::thread server_thread([&]() {
+        server.RunServer(socket_path, [&](int client_socket, std::string_view msg) {
+            if (msg == "w0") {
+                while (!release.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                write_done = true;
+            } else if (msg == "r1") {
+                read_saw_write = write_done.load();
+            }
+            server.SendResponse(client_socket, "echo:" + std::string(msg));
+        });
+    });
+
+    TestableService client("svc_client");
+    ASSERT_TRUE(ConnectWithRetry(client, socket_path));
+    client.SendMessages({"w0", "r1"});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // The read must not slip past
+    release = true;
+
+    // The read follows the client's queued write into its lane
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:w0"));
+    EXPECT_EQ(client.ReceiveMessage(), std::optional<std::string>("echo:r1"));
+    EXPECT_TRUE(read_saw_write.load());
+
+    server.StopServer();
+    server_thread.join();
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
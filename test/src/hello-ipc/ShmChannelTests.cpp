@@ -0,0 +1,188 @@
+#include "ShmChannel.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for the shared memory rings ---
+// Both ends of the channel live in the test process; Attach() maps a duplicate of
+// the client's descriptors just like the server does after SCM_RIGHTS.
+
+static std::unique_ptr<hello_ipc::ShmChannel> AttachCopy(const hello_ipc::ShmChannel &client) {
+    return hello_ipc::ShmChannel::Attach(dup(client.memfd()),
+                                         dup(client.event_fd(hello_ipc::ShmChannel::kRequest)),
+                                         dup(client.event_fd(hello_ipc::ShmChannel::kResponse)));
+}
+
+TEST(ShmChannelTest, WriteThenDrainRoundTrips) {
+    auto client = hello_ipc::ShmChannel::Create();
+    auto server = AttachCopy(*client);
+
+    const std::string head = "HEAD";
+    const std::string body = "body bytes";
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, head.data(), head.size(),
+                              body.data(), body.size(), 100));
+
+    std::string out;
+    ASSERT_TRUE(server->Drain(hello_ipc::ShmChannel::kRequest, out));
+    EXPECT_EQ(out, head + body);
+
+    // The response ring is independent of the request ring
+    out.clear();
+    ASSERT_TRUE(client->Drain(hello_ipc::ShmChannel::kResponse, out));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(ShmChannelTest, DataWrapsAroundTheRing) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    auto server = AttachCopy(*client);
+
+    // 3000 bytes twice forces the second write across the end of a 4096 byte ring
+    for (char fill : {'a', 'b'}) {
+        const std::string body(3000, fill);
+        ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, body.data(), body.size(), 100));
+        std::string out;
+        ASSERT_TRUE(server->Drain(hello_ipc::ShmChannel::kRequest, out));
+        EXPECT_EQ(out, body);
+    }
+}
+
+TEST(ShmChannelTest, ReadCopiesAtMostTheGivenLength) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    auto server = AttachCopy(*client);
+
+    // Leave the ring cursors near the end so the partial reads wrap around
+    const std::string filler(4000, 'x');
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, filler.data(), filler.size(), 100));
+    std::string drained;
+    ASSERT_TRUE(server->Drain(hello_ipc::ShmChannel::kRequest, drained));
+
+    const std::string body = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"
+                             "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, body.data(), body.size(), 100));
+
+    char out[100];
+    std::size_t copied = 0;
+    ASSERT_TRUE(server->Read(hello_ipc::ShmChannel::kRequest, out, sizeof(out), &copied));
+    EXPECT_EQ(std::string(out, copied), body.substr(0, 100));
+    ASSERT_TRUE(server->Read(hello_ipc::ShmChannel::kRequest, out, sizeof(out), &copied));
+    EXPECT_EQ(std::string(out, copied), body.substr(100));
+    ASSERT_TRUE(server->Read(hello_ipc::ShmChannel::kRequest, out, sizeof(out), &copied));
+    EXPECT_EQ(copied, 0u);
+}
+
+TEST(ShmChannelTest, WriteFailsWhenTheRingStaysFull) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    const std::string body(3000, 'x');
+
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, body.data(), body.size(), 10));
+    EXPECT_FALSE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, body.data(), body.size(), 10));
+    EXPECT_FALSE(client->Write(hello_ipc::ShmChannel::kRequest, "", 0, std::string(8192, 'x').data(), 8192, 10));
+}
+
+TEST(ShmChannelTest, WriteSomeStopsAtAFullRingUntilTheConsumerReads) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    auto server = AttachCopy(*client);
+    int server_event_fd = server->event_fd(hello_ipc::ShmChannel::kRequest);
+    const std::string body(5000, 'r');
+
+    std::size_t written = 0;
+    ASSERT_TRUE(server->WriteSome(hello_ipc::ShmChannel::kResponse, body.data(), body.size(), &written));
+    EXPECT_EQ(written, 4096u);
+    uint64_t count = 0;
+    EXPECT_LT(read(server_event_fd, &count, sizeof(count)), 0); // Nothing read yet, no wakeup
+
+    // Making room wakes the server on its own eventfd, so it can write the rest
+    std::string out;
+    ASSERT_TRUE(client->Drain(hello_ipc::ShmChannel::kResponse, out));
+    EXPECT_EQ(out.size(), 4096u);
+    ASSERT_EQ(read(server_event_fd, &count, sizeof(count)), static_cast<ssize_t>(sizeof(count)));
+
+    ASSERT_TRUE(server->WriteSome(hello_ipc::ShmChannel::kResponse, body.data() + written, body.size() - written,
+                                  &written));
+    EXPECT_EQ(written, 904u);
+}
+
+TEST(ShmChannelTest, OnlyTheFirstWriteToAnEmptyRingSignals) {
+    auto client = hello_ipc::ShmChannel::Create();
+    auto server = AttachCopy(*client);
+    int event_fd = server->event_fd(hello_ipc::ShmChannel::kRequest);
+
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "a", 1, "", 0, 100));
+    ASSERT_TRUE(client->Write(hello_ipc::ShmChannel::kRequest, "b", 1, "", 0, 100));
+
+    uint64_t count = 0;
+    ASSERT_EQ(read(event_fd, &count, sizeof(count)), static_cast<ssize_t>(sizeof(count)));
+    EXPECT_EQ(count, 1u);
+}
+
+TEST(ShmChannelTest, WaitReadableWakesUpOnWrite) {
+    auto client = hello_ipc::ShmChannel::Create();
+    auto server = AttachCopy(*client);
+
+    std::thread writer([&server]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        server->Write(hello_ipc::ShmChannel::kResponse, "pong", 4, "", 0, 100);
+    });
+    EXPECT_TRUE(client->WaitReadable(hello_ipc::ShmChannel::kResponse, 2000));
+    writer.join();
+
+    std::string out;
+    ASSERT_TRUE(client->Drain(hello_ipc::ShmChannel::kResponse, out));
+    EXPECT_EQ(out, "pong");
+}
+
+TEST(ShmChannelTest, AttachRejectsMemoryWithoutAChannel) {
+    int memfd = memfd_create("not_a_channel", MFD_CLOEXEC);
+    ASSERT_GE(memfd, 0);
+    ASSERT_EQ(ftruncate(memfd, 8192), 0);
+
+    EXPECT_THROW(hello_ipc::ShmChannel::Attach(memfd, eventfd(0, 0), eventfd(0, 0)), std::runtime_error);
+}
+
+TEST(ShmChannelTest, ChannelSizeIsSealed) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    EXPECT_LT(ftruncate(client->memfd(), 0), 0);
+}
+
+TEST(ShmChannelTest, AttachRejectsAnUnsealedChannel) {
+    // A valid channel in memory the client could still shrink under the server
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    struct stat st;
+    ASSERT_EQ(fstat(client->memfd(), &st), 0);
+    std::string bytes(static_cast<std::size_t>(st.st_size), '\0');
+    ASSERT_EQ(pread(client->memfd(), bytes.data(), bytes.size(), 0), static_cast<ssize_t>(bytes.size()));
+
+    int memfd = memfd_create("unsealed_channel", MFD_CLOEXEC);
+    ASSERT_GE(memfd, 0);
+    ASSERT_EQ(write(memfd, bytes.data(), bytes.size()), static_cast<ssize_t>(bytes.size()));
+
+    EXPECT_THROW(hello_ipc::ShmChannel::Attach(memfd, eventfd(0, 0), eventfd(0, 0)), std::runtime_error);
+}
+
+TEST(ShmChannelTest, RewrittenCapacityDoesNotMoveTheRings) {
+    auto client = hello_ipc::ShmChannel::Create(4096);
+    auto server = AttachCopy(*client);
+
+    // The capacity follows the 4-byte magic; a peer enlarges it after the server attached
+    const uint32_t huge = 1u << 30;
+    ASSERT_EQ(pwrite(client->memfd(), &huge, sizeof(huge), 4), static_cast<ssize_t>(sizeof(huge)));
+
+    ASSERT_TRUE(server->Write(hello_ipc::ShmChannel::kResponse, "", 0, "pong", 4, 100));
+    std::string out;
+    ASSERT_TRUE(client->Drain(hello_ipc::ShmChannel::kResponse, out));
+    EXPECT_EQ(out, "pong");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
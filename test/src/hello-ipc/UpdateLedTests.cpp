@@ -28,6 +28,16 @@ public:
         const_cast<TestableUpdateLed*>(this)->sentMessages.push_back(message);
     }
 
+    // Batched sends are captured message by message
+    void SendMessages(const std::vector<std::string>& messages) const override {
+        const_cast<TestableUpdateLed*>(this)->sendBatches++;
+        for (const auto& message : messages) {
+            SendMessage(message);
+        }
+    }
+
+    int sendBatches = 0;
+
     // Override ReceiveMessage to provide mocked responses
     std::optional<std::string> ReceiveMessage() override {
         if (receiveCount < (int)responses.size()) {
@@ -38,8 +48,10 @@ public:
 };
 
 // Helper function to create a mock response
-std::string CreateMockResponse(const std::string& led_num, hello_ipc::LedState state, const std::string& error = "") {
+std::string CreateMockResponse(const std::string& led_num, hello_ipc::LedState state, const std::string& error = "",
+                               uint64_t request_id = 0) {
     hello_ipc::Response res;
+    res.set_request_id(request_id);
     auto* state_res = res.mutable_state_response();
     state_res->set_led_num(led_num);
     if (error.empty()) {
@@ -67,17 +79,46 @@ TEST(UpdateLedTest, HandleArgumentsSendsCorrectProtobuf) {
     hello_ipc::Request req1;
     ASSERT_TRUE(req1.ParseFromString(updater.sentMessages[0]));
     ASSERT_TRUE(req1.has_update_request());
-    EXPECT_EQ(req1.update_request().led_num(), "1");
+    EXPECT_EQ(req1.update_request().led_id(), 1u);
     EXPECT_EQ(req1.update_request().state(), hello_ipc::LedState::ON);
 
     // Verify second message
     hello_ipc::Request req2;
     ASSERT_TRUE(req2.ParseFromString(updater.sentMessages[1]));
     ASSERT_TRUE(req2.has_update_request());
-    EXPECT_EQ(req2.update_request().led_num(), "2");
+    EXPECT_EQ(req2.update_request().led_id(), 2u);
     EXPECT_EQ(req2.update_request().state(), hello_ipc::LedState::ON);
 }
 
+TEST(UpdateLedTest, HandleArgumentsPipelinesRequestsAndMatchesResponsesById) {
+    const char* argv[] = {"prog", "--update-led", "--led1", "--led2", "--led3"};
+    TestableUpdateLed updater(5, const_cast<char**>(argv));
+
+    // Answer out of order, the responses must still be matched by request id
+    updater.responses.push_back(CreateMockResponse("3", hello_ipc::LedState::ON, "", 3));
+    updater.responses.push_back(CreateMockResponse("1", hello_ipc::LedState::ON, "", 1));
+    updater.responses.push_back(CreateMockResponse("2", hello_ipc::LedState::ON, "LED 2 is broken", 2));
+
+    testing::internal::CaptureStdout();
+    updater.HandleArguments();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    // All three requests leave in a single batch, each with its own id
+    EXPECT_EQ(updater.sendBatches, 1);
+    ASSERT_EQ(updater.sentMessages.size(), 3);
+    for (uint64_t i = 0; i < 3; ++i) {
+        hello_ipc::Request req;
+        ASSERT_TRUE(req.ParseFromString(updater.sentMessages[i]));
+        EXPECT_EQ(req.request_id(), i + 1);
+        EXPECT_EQ(req.update_request().led_id(), static_cast<uint32_t>(i + 1));
+    }
+
+    EXPECT_EQ(updater.receiveCount, 3);
+    EXPECT_THAT(output, testing::HasSubstr("Response: Led3 Updated"));
+    EXPECT_THAT(output, testing::HasSubstr("Response: Led1 Updated"));
+    EXPECT_THAT(output, testing::HasSubstr("Error from server: LED 2 is broken"));
+}
+
 TEST(UpdateLedTest, HandleUserInputSendsOnAndOff) {
     const char* argv[] = {"prog", "--update-led"};
     TestableUpdateLed updater(2, const_cast<char**>(argv));
@@ -93,13 +134,13 @@ TEST(UpdateLedTest, HandleUserInputSendsOnAndOff) {
     // Verify ON message
     hello_ipc::Request req_on;
     ASSERT_TRUE(req_on.ParseFromString(updater.sentMessages[0]));
-    EXPECT_EQ(req_on.update_request().led_num(), "1");
+    EXPECT_EQ(req_on.update_request().led_id(), 1u);
     EXPECT_EQ(req_on.update_request().state(), hello_ipc::LedState::ON);
 
     // Verify OFF message
     hello_ipc::Request req_off;
     ASSERT_TRUE(req_off.ParseFromString(updater.sentMessages[1]));
-    EXPECT_EQ(req_off.update_request().led_num(), "2");
+    EXPECT_EQ(req_off.update_request().led_id(), 2u);
     EXPECT_EQ(req_off.update_request().state(), hello_ipc::LedState::OFF);
 }
 
@@ -117,6 +158,37 @@ TEST(UpdateLedTest, SendUpdateHandlesServerError) {
     EXPECT_THAT(output, testing::HasSubstr("Error from server: System is on fire"));
 }
 
+TEST(UpdateLedTest, CompareAndSetSendsRequestAndReturnsOutcome) {
+    const char* argv[] = {"prog", "--update-led"};
+    TestableUpdateLed updater(2, const_cast<char**>(argv));
+
+    hello_ipc::Response mock_res;
+    mock_res.set_request_id(1);
+    auto* cas_res = mock_res.mutable_compare_and_set_response();
+    cas_res->set_led_id(4);
+    cas_res->set_observed(hello_ipc::LedState::ON);
+    cas_res->set_swapped(false);
+    std::string response_str;
+    mock_res.SerializeToString(&response_str);
+    updater.responses.push_back(response_str);
+
+    auto result = updater.CompareAndSet(4, hello_ipc::LedState::OFF, hello_ipc::LedState::ON);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_FALSE(result->swapped());
+    EXPECT_EQ(result->observed(), hello_ipc::LedState::ON);
+
+    ASSERT_EQ(updater.sentMessages.size(), 1u);
+    hello_ipc::Request req;
+    ASSERT_TRUE(req.ParseFromString(updater.sentMessages[0]));
+    ASSERT_TRUE(req.has_compare_and_set_request());
+    EXPECT_EQ(req.compare_and_set_request().led_id(), 4u);
+    EXPECT_EQ(req.compare_and_set_request().expected(), hello_ipc::LedState::OFF);
+    EXPECT_EQ(req.compare_and_set_request().desired(), hello_ipc::LedState::ON);
+
+    // No response, no outcome
+    EXPECT_FALSE(updater.CompareAndSet(4, hello_ipc::LedState::OFF, hello_ipc::LedState::ON).has_value());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,72 @@
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// --- Unit Tests for WorkerPool ---
+
+TEST(WorkerPoolTest, TasksWithTheSameKeyRunInOrder) {
+    std::mutex mutex;
+    std::vector<int> order;
+    {
+        hello_ipc::WorkerPool pool(4);
+        for (int i = 0; i < 1000; ++i) {
+            pool.Submit(7, [&, i]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+            });
+        }
+    } // Drains and joins
+
+    ASSERT_EQ(order.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(WorkerPoolTest, FloodingKeyDoesNotStarveOthersOnTheSameWorker) {
+    std::atomic<bool> release{false};
+    std::vector<std::size_t> order; // Only touched by the single worker
+    {
+        hello_ipc::WorkerPool pool(1);
+        pool.Submit(0, [&]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        for (int i = 0; i < 100; ++i) {
+            pool.Submit(1, [&]() { order.push_back(1); });
+        }
+        pool.Submit(2, [&]() { order.push_back(2); });
+        pool.Submit(3, [&]() { order.push_back(3); });
+        release = true;
+    }
+
+    // Round-robin over the queued keys: one task of the flooding key, then the others
+    ASSERT_EQ(order.size(), 102u);
+    EXPECT_EQ(order[0], 1u);
+    EXPECT_EQ(order[1], 2u);
+    EXPECT_EQ(order[2], 3u);
+}
+
+TEST(WorkerPoolTest, KeyIsServedAgainAfterItsQueueRanEmpty) {
+    std::atomic<int> runs{0};
+    hello_ipc::WorkerPool pool(2);
+    for (int round = 0; round < 3; ++round) {
+        pool.Submit(5, [&runs]() { ++runs; });
+        for (int i = 0; i < 500 && runs.load() <= round; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(runs.load(), round + 1);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}